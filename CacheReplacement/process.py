@@ -17,6 +17,12 @@ g.write('| **Program** | **LRU_time** | **LRU_CPI** | **LRU_miss** | \
 -------: | ----: | ----: | \
 -------: | ----: | ----: |\n')
 
+def line_after(lines, header):
+	# find the last section with this header rather than counting lines from
+	# the end, so new statistics sections don't shift the fields we read
+	stripped = [l.strip() for l in lines]
+	return lines[len(stripped) - 1 - stripped[::-1].index(header) + 1]
+
 algorithm = ['LRU', 'Random', 'DRRIP']
 m3 = [0] * 3
 c3 = [0] * 3
@@ -26,13 +32,10 @@ for (i, file) in enumerate(glob.glob(os.getcwd().replace('\\', '/') + '/runs/*')
 			g.write('| ' + file.split('.')[1][:-1])
 		lines = f.read().decode('utf-8').split('\n')
 		g.write(' | ' + t[3 * i].replace('\n', '').split(' ')[-1])
-		try:
-			cpi = lines[-44].split(' ')[-7]
-		except:
-			cpi = lines[-39].split(' ')[-7]
+		cpi = line_after(lines, 'Region of Interest Summary:').split(' ')[-7]
 		g.write(' | ' + cpi)
 		c3[i % 3] = float(cpi)
-		miss = lines[-6].split(' ')[-1]
+		miss = line_after(lines, 'Per Thread Demand Reference Statistics:').split(' ')[-1]
 		g.write(' | ' + miss)
 		m3[i % 3] = float(miss)
 		if i % 3 == 2:
@@ -38,12 +38,14 @@ string crc_access_names[] =
 // The constructor for the cache with appropriate cache parameters as args    //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol ) 
+CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                      UINT32 _shards, UINT32 _shard ) 
 {
 
     // Start off with empty cache and replacement state
-    cache          = NULL;
+    tagStore       = NULL;
     cacheReplState = NULL;
+    sampler        = NULL;
 
     // Initialize parameters to the cache
     numsets  = _cacheSize / (_linesize * _assoc);
@@ -51,6 +53,12 @@ CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _lin
     threads  = _tpc;
     linesize = _linesize;
 
+    shardShift = CRC_FloorLog2( _shards );
+    shard      = _shard;
+
+    // ensure that the shards split the sets evenly
+    assert( (1U << shardShift) == _shards && _shards <= numsets && _shard < _shards );
+
     replPolicy = _pol;
 
     // Initialize the cache
@@ -63,6 +71,22 @@ CRC_CACHE::CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _lin
     InitStats();
 }
 
+CRC_CACHE::~CRC_CACHE()
+{
+    delete tagStore;
+    delete cacheReplState;
+    delete sampler;
+
+    for(UINT32 i=0; i<ACCESS_MAX; i++) 
+    {
+        delete [] lookups[i];
+        delete [] misses[i];
+        delete [] hits[i];
+    }
+
+    delete [] dirtyEvictions;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
 // The function initializes the cache hardware and structures                 //
@@ -75,26 +99,14 @@ void CRC_CACHE::InitCache()
     indexShift = CRC_FloorLog2( numsets );    
     indexMask  = (1 << indexShift) - 1;
 
-    // Create the cache structure (first create the sets)
-    cache = new LINE_STATE* [ numsets ];
-
-    // ensure that we were able to create cache
-    assert(cache);
+    // a shard only holds its own sets
+    numsets >>= shardShift;
 
-    // If we were able to create the sets, now create the ways
-    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
-    {
-        cache[ setIndex ] = new LINE_STATE[ assoc ];
+    // Create the cache structure (tags, valid, dirty and sharing arrays)
+    tagStore = new CRC_TAG_STORE( numsets, assoc );
 
-        // Initialize the cache ways
-        for(UINT32 way=0; way<assoc; way++) 
-        {
-            cache[ setIndex ][ way ].tag   = 0xdeaddead;
-            cache[ setIndex ][ way ].valid = false;
-            cache[ setIndex ][ way ].dirty = false;
-            cache[ setIndex ][ way ].sharing_dir   = 0;
-        }
-    }
+    // ensure that we were able to create cache
+    assert(tagStore);
 
     // Initialize cache access timer
     mytimer = 0;
@@ -121,6 +133,34 @@ void CRC_CACHE::InitStats()
             hits[i][t]    = 0;
         }
     }
+
+    dirtyEvictions = new COUNTER[ threads ];
+
+    for(UINT32 t=0; t<threads; t++) 
+    {
+        dirtyEvictions[t] = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function switches the cache to set sampling: from now on only the      //
+// sets picked by CRC_SET_SAMPLER are simulated, and their statistics are     //
+// extrapolated to the whole cache. CRC_SAMPLE_NONE (or k = 1 with stride)    //
+// simulates every set again.                                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::SetSampling( UINT32 mode, UINT32 k )
+{
+    // the sample cannot change under a running simulation
+    assert( mytimer == 0 );
+
+    delete sampler;
+    sampler = NULL;
+
+    if( mode == CRC_SAMPLE_NONE || (mode == CRC_SAMPLE_STRIDE && k <= 1) ) return;
+
+    sampler = new CRC_SET_SAMPLER( numsets, threads, mode, k, cacheReplState );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -143,6 +183,10 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
     out<<"\tAssociativity:  "<<assoc<<endl;
     out<<"\tTot # Sets:     "<<numsets<<endl;
     out<<"\tTot # Threads:  "<<threads<<endl;
+    if( sampler ) 
+    {
+        out<<"\tSimulated Sets: "<<sampler->SimulatedSets()<<endl;
+    }
     
     out<<endl;
     out<<"Cache Statistics: "<<endl;
@@ -173,6 +217,13 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
         }
     }
 
+    if( sampler ) 
+    {
+        sampler->PrintStats( out, crc_access_names );
+    }
+
+    PrintOccupancyStats( out );
+
     out<<endl;
     out<<"Per Thread Demand Reference Statistics: "<<endl;
 
@@ -197,51 +248,89 @@ ostream & CRC_CACHE::PrintStats(ostream &out)
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// The function slects a victim for the given set index. We enforce that      //
-// we first fill all invalid entries. Once all invalid entries are filled     //
-// the replacement policy is consulted to find the victim                     //
+// The function prints how full the sets are and how many lines are dirty,    //
+// from popcounts of the per-set valid/dirty bitmasks                         //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CRC_CACHE::GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
+ostream & CRC_CACHE::PrintOccupancyStats(ostream &out)
 {
-    // Get pointer to replacement state of current set
-    LINE_STATE *vicSet = cache[ setIndex ];
+    COUNTER totValid = 0, totDirty = 0, fullSets = 0;
+    UINT32  minValid = assoc, maxValid = 0;
+    UINT32  minDirty = assoc, maxDirty = 0;
 
-    // First find and fill invalid lines
-    for(UINT32 way=0; way<assoc; way++) 
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
     {
-        if( vicSet[way].valid == false ) 
-        {
-            return way;
-        }
+        UINT32 valid = tagStore->SetValidCount( setIndex );
+        UINT32 dirty = tagStore->SetDirtyCount( setIndex );
+
+        totValid += valid;
+        totDirty += dirty;
+        fullSets += (valid == assoc);
+
+        if( valid < minValid ) minValid = valid;
+        if( valid > maxValid ) maxValid = valid;
+        if( dirty < minDirty ) minDirty = dirty;
+        if( dirty > maxDirty ) maxDirty = dirty;
     }
 
-    // If no invalid lines, then replace based on replacement policy
-    return cacheReplState->GetVictimInSet( tid, setIndex, vicSet, assoc, PC, paddr, accessType );
+    COUNTER lines = (COUNTER)numsets * assoc;
+
+    out<<"Occupancy Statistics: "<<endl;
+    out<<endl;
+    out<<"\tValid Lines:     "<<totValid<<" ("<<((double)totValid/(double)lines)*100.0<<"%)"<<endl;
+    out<<"\tDirty Lines:     "<<totDirty<<" ("<<((double)totDirty/(double)lines)*100.0<<"%)"<<endl;
+    out<<"\tFull Sets:       "<<fullSets<<endl;
+    out<<"\tValid Per Set:   min "<<minValid<<" avg "<<(double)totValid/numsets<<" max "<<maxValid<<endl;
+    out<<"\tDirty Per Set:   min "<<minDirty<<" avg "<<(double)totDirty/numsets<<" max "<<maxDirty<<endl;
+    out<<"\tDirty Evictions: "<<DirtyEvictionStats()<<endl;
+    out<<endl;
+
+    return out;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// The function looks up the set for the tag and returns physical way index   //
-// if the tag was a hit. Else returns -1 if it was a miss.                    //
+// The function slects a victim for the given set index. We enforce that      //
+// we first fill all invalid entries (the lowest clear bit of the set's       //
+// valid mask). Once all invalid entries are filled the replacement policy    //
+// is consulted to find the victim                                            //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CRC_CACHE::LookupSet( UINT32 setIndex, Addr_t tag )
+template <class POLICY>
+inline INT32 CRC_CACHE::GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
 {
-    // Get pointer to current set
-    LINE_STATE *currSet = cache[ setIndex ];
+    // First find and fill invalid lines
+    INT32 way = tagStore->FindInvalid( setIndex );
 
-    // Find Tag
-    for(UINT32 way=0; way<assoc; way++) 
+    if( way != -1 ) 
     {
-        if( currSet[way].valid && (currSet[way].tag == tag) ) 
-        {
-            return way;
-        }
+        return way;
     }
 
-    // If not found, return -1
-    return -1;
+    // Only build the LINE_STATE view of the set if the policy reads it
+    const LINE_STATE *vicSet = (POLICY::mayInspectSet && replInspectsLines) ? tagStore->SetView( setIndex ) : NULL;
+
+    // If no invalid lines, then replace based on replacement policy
+    way = POLICY::Victim( cacheReplState, tid, setIndex, vicSet, assoc, PC, paddr, accessType );
+
+#ifdef CRC_INSTRUMENT
+    if( cacheReplState->Instrumented() ) cacheReplState->InstrumentVictim( setIndex, way );
+#endif
+
+    return way;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function looks up the set for the tag and returns physical way index   //
+// if the tag was a hit. Else returns -1 if it was a miss. All ways of the    //
+// set are compared by the SIMD tag match kernel selected for this host.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+INT32 CRC_CACHE::LookupSet( UINT32 setIndex, Addr_t tag )
+{
+    // Find Tag (-1 if not found)
+    return tagStore->Lookup( setIndex, tag );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -274,8 +363,80 @@ bool CRC_CACHE::CacheInspect( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 access
 ////////////////////////////////////////////////////////////////////////////////
 bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
 {
+    return (this->*lookupFn)( tid, PC, paddr, accessType );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function processes a batch of accesses in order, with exactly the     //
+// same effect as calling LookupAndFillCache on each of them. While access i  //
+// is processed, the tag store and replacement state lines of the set that    //
+// access i+CRC_BATCH_PREFETCH_DISTANCE maps to are prefetched, so the host   //
+// memory latency of upcoming sets overlaps with the work on the current      //
+// one. hitsOut (may be NULL) receives the hit/miss result of each access.    //
+// The policy is dispatched once per batch, not once per access.              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::LookupAndFillBatch( const Access *reqs, size_t n, bool *hitsOut )
+{
+    (this->*batchFn)( reqs, n, hitsOut );
+}
+
+template <class POLICY>
+void CRC_CACHE::LookupAndFillRun( const Access *reqs, size_t n, bool *hitsOut )
+{
+    size_t warm = (n < CRC_BATCH_PREFETCH_DISTANCE) ? n : CRC_BATCH_PREFETCH_DISTANCE;
+
+    for(size_t i=0; i<warm; i++) 
+    {
+        PrefetchSet( GetSetIndex( reqs[i].paddr ) );
+    }
+
+    for(size_t i=0; i<n; i++) 
+    {
+        if( i + CRC_BATCH_PREFETCH_DISTANCE < n ) 
+        {
+            PrefetchSet( GetSetIndex( reqs[ i + CRC_BATCH_PREFETCH_DISTANCE ].paddr ) );
+        }
+
+        bool hit = LookupAndFill<POLICY>( reqs[i].tid, reqs[i].PC, reqs[i].paddr, reqs[i].accessType );
 
-    LINE_STATE *currLine = NULL;
+        if( hitsOut ) 
+        {
+            hitsOut[i] = hit;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prefetches the metadata of a set ahead of its use             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CRC_CACHE::PrefetchSet( UINT32 setIndex )
+{
+    if( sampler && !sampler->Simulated( setIndex ) ) return;
+
+    tagStore->PrefetchSet( setIndex );
+    cacheReplState->PrefetchSet( setIndex );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Single access lookup and fill shared by LookupAndFillCache and             //
+// LookupAndFillBatch                                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+template <class POLICY>
+inline bool CRC_CACHE::LookupAndFill( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) 
+{
+
+    const LINE_STATE *currLine = NULL;
+
+    UINT32 setIndex = GetSetIndex( paddr );  // Get the set index
+
+    // Accesses to sets outside the sample are dropped untouched
+    if( sampler && !sampler->Simulated( setIndex ) ) return false;
 
     // for modeling LRU
     ++mytimer;     
@@ -286,7 +447,6 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
 
     // Process request
     bool  hit       = true;
-    UINT32 setIndex = GetSetIndex( paddr );  // Get the set index
     Addr_t tag      = GetTag( paddr );       // Determine Cache Tag
 
     // Lookup the cache set to determine whether line is already in cache or not
@@ -298,20 +458,21 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
         hit = false;
 
         // get victim line to replace (wayID = -1, then bypass)
-        wayID     = GetVictimInSet( tid, setIndex, PC, paddr, accessType );
+        wayID     = GetVictimInSet<POLICY>( tid, setIndex, PC, paddr, accessType );
 
         if( wayID != -1 )
         {
-            currLine  = &cache[ setIndex ][ wayID ];
+            bool isStore = IS_STORE( accessType );
 
-            // Update the line state accordingly
-            currLine->valid          = true;
-            currLine->tag            = tag;
-            currLine->dirty          = IS_STORE( accessType );
-            currLine->sharing_dir    = (1<<tid);
+            // Update the line state accordingly (the victim is written back if dirty)
+            if( tagStore->Fill( setIndex, wayID, tag, isStore, (1<<tid) ) )
+            {
+                dirtyEvictions[ tid ]++;
+            }
+            if( POLICY::mayInspectLines && replInspectsLines ) currLine = tagStore->LineView( setIndex, wayID );
 
             // Update Replacement State
-            cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, hit );
+            POLICY::Update( cacheReplState, setIndex, wayID, currLine, tid, PC, accessType, hit );
         }
         
         // Update Stats
@@ -319,23 +480,28 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
     }
     else 
     {
-        // get pointer to cache line we hit
-        currLine         = &cache[ setIndex ][ wayID ];
+        bool isStore = IS_STORE( accessType );
 
         // Update the line state accordingly
-        currLine->dirty         |= IS_STORE( accessType );
-        currLine->sharing_dir   |= (1<<tid);
+        tagStore->Touch( setIndex, wayID, isStore, (1<<tid) );
+        if( POLICY::mayInspectLines && replInspectsLines ) currLine = tagStore->LineView( setIndex, wayID );
 
         // Update Replacement State
         if( accessType != ACCESS_WRITEBACK ) 
         {
-            cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, hit );
+            POLICY::Update( cacheReplState, setIndex, wayID, currLine, tid, PC, accessType, hit );
         }
 
         // Update Stats
         hits[ accessType ][ tid ]++;
     }        
 
+#ifdef CRC_INSTRUMENT
+    if( cacheReplState->Instrumented() ) cacheReplState->InstrumentAccess( setIndex, wayID, accessType, hit );
+#endif
+
+    if( sampler ) sampler->Record( setIndex, tid, accessType, hit );
+
     return hit;
 }
 
@@ -347,5 +513,92 @@ bool CRC_CACHE::LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32
 ////////////////////////////////////////////////////////////////////////////////
 void CRC_CACHE::InitCacheReplacementState()
 {
-    cacheReplState = new CACHE_REPLACEMENT_STATE( numsets, assoc, replPolicy );
+    cacheReplState  = new CACHE_REPLACEMENT_STATE( numsets, assoc, replPolicy );
+    cacheReplState->SetNumThreads( threads );
+    if( shardShift ) cacheReplState->SetInterleave( numsets << shardShift, 1 << shardShift, shard );
+    cacheReplState->SetLineSize( linesize );
+    replInspectsLines = cacheReplState->InspectsLineState();
+
+    SelectAccessPath( true );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function picks the instantiation of the access path for the policy.   //
+// Policies without a specialization (and every policy when specialized is    //
+// false) take the generic path, which dispatches on the policy number in     //
+// CACHE_REPLACEMENT_STATE on every access.                                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_CACHE::SelectAccessPath( bool specialized )
+{
+    lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_GENERIC>;
+    batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_GENERIC>;
+
+    if( !specialized ) return;
+
+    switch( replPolicy ) 
+    {
+        case CRC_REPL_LRU:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_LRU>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_LRU>;
+            break;
+
+        case CRC_REPL_RANDOM:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_RANDOM>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_RANDOM>;
+            break;
+
+        case CRC_REPL_CONTESTANT:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_DRRIP>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_DRRIP>;
+            break;
+
+        case CRC_REPL_SHIP:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_SHIP>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_SHIP>;
+            break;
+
+        case CRC_REPL_HAWKEYE:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_HAWKEYE>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_HAWKEYE>;
+            break;
+
+        case CRC_REPL_OPT:
+        case CRC_REPL_OPT_BYPASS:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_OPT>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_OPT>;
+            break;
+
+        case CRC_REPL_TREE_PLRU:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_TREE_PLRU>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_TREE_PLRU>;
+            break;
+
+        case CRC_REPL_NRU:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_NRU>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_NRU>;
+            break;
+
+        case CRC_REPL_EAF:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_EAF>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_EAF>;
+            break;
+
+        case CRC_REPL_SDBP:
+        case CRC_REPL_SDBP_BYPASS:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_SDBP>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_SDBP>;
+            break;
+
+        case CRC_REPL_PERCEPTRON:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_PERCEPTRON>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_PERCEPTRON>;
+            break;
+
+        case CRC_REPL_ARC:
+            lookupFn = &CRC_CACHE::LookupAndFill<CRC_POLICY_ARC>;
+            batchFn  = &CRC_CACHE::LookupAndFillRun<CRC_POLICY_ARC>;
+            break;
+    }
 }
@@ -27,6 +27,12 @@
 #include "utils.h"
 #include "replacement_state.h"
 #include "crc_cache_defs.h"
+#include "crc_trace.h"
+#include "crc_tag_store.h"
+#include "crc_set_sample.h"
+
+// How many accesses ahead LookupAndFillBatch prefetches set metadata
+#define CRC_BATCH_PREFETCH_DISTANCE 8
 
 class CRC_CACHE
 {
@@ -39,66 +45,144 @@ class CRC_CACHE
     UINT32 linesize;
     UINT32 replPolicy;
     
-    LINE_STATE               **cache;
+    CRC_TAG_STORE            *tagStore;
     CACHE_REPLACEMENT_STATE  *cacheReplState;
 
+    // does the policy read the LINE_STATE of the set or line it is given?
+    bool replInspectsLines;
+
+    // access path instantiated for the replacement policy (see
+    // CRC_POLICY_GENERIC in replacement_state.h)
+    typedef bool (CRC_CACHE::*LOOKUP_FN)( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    typedef void (CRC_CACHE::*BATCH_FN)( const Access *reqs, size_t n, bool *hitsOut );
+
+    LOOKUP_FN lookupFn;
+    BATCH_FN  batchFn;
+
+    // simulated subset of the sets (NULL: all sets are simulated)
+    CRC_SET_SAMPLER          *sampler;
+
     // statistics
     COUNTER *lookups[ ACCESS_MAX ];
     COUNTER *misses[ ACCESS_MAX ];
     COUNTER *hits[ ACCESS_MAX ];
+    COUNTER *dirtyEvictions;
 
     // Lookup Parameters
     UINT32 lineShift;
     UINT32 indexShift;
     UINT32 indexMask;
 
+    // a shard holds set shard, shard + 2^shardShift, ... of the cache, and
+    // global set s is its set s >> shardShift (see CRC_PARALLEL_CACHE)
+    UINT32 shardShift;
+    UINT32 shard;
+
     COUNTER mytimer; 
     
   public:
 
-    CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize=64, UINT32 _pol=CRC_REPL_LRU );
+    // With _shards (a power of two) above 1, only shard _shard of the cache:
+    // the sets whose index is _shard modulo _shards. Only accesses to those
+    // sets may be made.
+    CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize=64, UINT32 _pol=CRC_REPL_LRU,
+               UINT32 _shards=1, UINT32 _shard=0 );
+    ~CRC_CACHE();
 
     bool   CacheInspect( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
     bool   LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    void   LookupAndFillBatch( const Access *reqs, size_t n, bool *hitsOut );
     ostream &   PrintStats(ostream &out);
 
+    // Select the SIMD tag match kernel (defaults to the best the host supports)
+    void   SetTagMatchKernel( UINT32 kernel ) { tagStore->SetTagMatchKernel( kernel ); }
+
+    // Use the access path specialized for the replacement policy (default)
+    // or the generic one that dispatches on the policy number per access
+    void   SelectAccessPath( bool specialized );
+
+    // Simulate only the leader sets plus 1 in k of the others (see
+    // crc_set_sample.h); must be called before the first access
+    void   SetSampling( UINT32 mode, UINT32 k );
+    CRC_SET_SAMPLER *SetSampler() { return sampler; }
+
+    // Size the SHiP tables (see CACHE_REPLACEMENT_STATE::ConfigureSHiP);
+    // must be called before the first access
+    void   ConfigureSHiP( UINT32 shctBits, UINT32 signatureBits ) { cacheReplState->ConfigureSHiP( shctBits, signatureBits ); }
+
+    // DRRIP set dueling (see CACHE_REPLACEMENT_STATE::ConfigureDueling);
+    // before the first access and before SetSampling, which keeps the
+    // leader sets
+    void   ConfigureDueling( UINT32 leaders, UINT32 counterBits, COUNTER traceInterval ) { cacheReplState->ConfigureDueling( leaders, counterBits, traceInterval ); }
+
+    // Next-use index for the OPT policies (see crc_next_use.h); entry i is
+    // for the i-th access to this cache, so it does not mix with sampling
+    void   SetNextUse( const unsigned long long *entries, COUNTER records ) { cacheReplState->SetNextUse( entries, records ); }
+
+    // Replacement-policy probes sampled every interval accesses (see
+    // crc_instrument.h); builds with CRC_INSTRUMENT only, before the first
+    // access and after the policy is configured
+    void   EnableInstrumentation( COUNTER interval ) { cacheReplState->EnableInstrumentation( interval ); }
+
   private:
 
     Addr_t GetTag( Addr_t addr ) { return ((addr >> lineShift) >> indexShift); }
-    UINT32 GetSetIndex( Addr_t addr ) { return ((addr >> lineShift) & indexMask); }
+    UINT32 GetSetIndex( Addr_t addr ) { return ((addr >> lineShift) & indexMask) >> shardShift; }
 
     void   InitCache();
     void   InitCacheReplacementState();
 
     void   InitStats();
+    ostream &   PrintOccupancyStats(ostream &out);
+
+    template <class POLICY> bool LookupAndFill( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    template <class POLICY> void LookupAndFillRun( const Access *reqs, size_t n, bool *hitsOut );
+    void   PrefetchSet( UINT32 setIndex );
 
     INT32  LookupSet( UINT32 setIndex, Addr_t tag );
-    INT32  GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType );
+    template <class POLICY> INT32 GetVictimInSet( UINT32 tid, UINT32 setIndex, Addr_t PC, Addr_t paddr, UINT32 accessType );
 
   public:
 
-    // Statistics related functions
+    // Statistics related functions (extrapolated to all sets when sampling)
     COUNTER ThreadDemandLookupStats( UINT32 tid )
     {
         COUNTER stat = 0;
         for(UINT32 a=0; a<=ACCESS_STORE; a++) stat  += lookups[a][tid];
-        return stat;
+        return sampler ? sampler->ThreadDemandLookups( tid, stat ) : stat;
     }
 
     COUNTER ThreadDemandMissStats( UINT32 tid )
     {
         COUNTER stat = 0;
         for(UINT32 a=0; a<=ACCESS_STORE; a++) stat  += misses[a][tid];
-        return stat;
+        return sampler ? sampler->ThreadDemandMisses( tid, stat ) : stat;
     }
     
     COUNTER ThreadDemandHitStats( UINT32 tid )
     {
+        if( sampler ) return ThreadDemandLookupStats( tid ) - ThreadDemandMissStats( tid );
+
         COUNTER stat = 0;
         for(UINT32 a=0; a<=ACCESS_STORE; a++) stat  += hits[a][tid];
         return stat;
     }
 
+    // Writeback traffic: dirty lines evicted so far and dirty lines resident
+    COUNTER DirtyEvictionStats()
+    {
+        COUNTER stat = 0;
+        for(UINT32 t=0; t<threads; t++) stat  += dirtyEvictions[t];
+        return stat;
+    }
+
+    COUNTER DirtyLineCount() { return tagStore->DirtyLineCount(); }
+
+    // Lines resident
+    COUNTER ValidLineCount() { return tagStore->ValidLineCount(); }
+
+    CACHE_REPLACEMENT_STATE *ReplacementState() { return cacheReplState; }
+
 };
 
 #endif
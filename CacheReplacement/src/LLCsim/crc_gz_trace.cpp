@@ -0,0 +1,246 @@
+#include <cstring>
+#include <sched.h>
+#include <time.h>
+#include "crc_gz_trace.h"
+
+// Polls of an empty ring before a waiting thread yields its core
+#define CRC_GZ_SPIN 64
+
+// Compressed input buffered by zlib
+#define CRC_GZ_INPUT_BUFFER (256 * 1024)
+
+static double GzNow()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void GzBackoff( UINT32 &spins )
+{
+    if( ++spins > CRC_GZ_SPIN )
+    {
+        sched_yield();
+        spins = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor reads and checks the header on the calling thread, then    //
+// hands every buffer of the pool to the inflate thread and starts it         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_GZ_TRACE_READER::CRC_GZ_TRACE_READER( const char *path )
+{
+    memset( &header, 0, sizeof(header) );
+
+    started       = false;
+    stop          = false;
+    holding       = false;
+    held          = 0;
+    finished      = false;
+    consumed      = 0;
+    consumerStall = 0;
+    inflated      = 0;
+    inflateBusy   = 0;
+    producerStall = 0;
+    readError     = false;
+
+    filled = new CRC_SPSC_RING<CRC_GZ_CHUNK>( 2 * CRC_GZ_BUFFERS );
+    empty  = new CRC_SPSC_RING<UINT32>( 2 * CRC_GZ_BUFFERS );
+
+    for(UINT32 b=0; b<CRC_GZ_BUFFERS; b++)
+    {
+        pool[b] = (Access *) CRC_AlignedAlloc( CRC_GZ_BUFFER_RECORDS * sizeof(Access) );
+
+        // ensure that we were able to create the buffer
+        assert( pool[b] );
+
+        empty->PushMany( &b, 1 );
+    }
+
+    gz = gzopen( path, "rb" );
+    ok = gz != NULL;
+
+    if( ok )
+    {
+        gzbuffer( gz, CRC_GZ_INPUT_BUFFER );
+
+        ok = gzread( gz, &header, sizeof(header) ) == (int)sizeof(header)
+                && !memcmp( header.magic, CRC_TRACE_MAGIC, sizeof(header.magic) )
+                && header.version == CRC_TRACE_VERSION;
+    }
+
+    if( !ok )
+    {
+        header.records = 0;
+        return;
+    }
+
+    started = pthread_create( &thread, NULL, InflateMain, this ) == 0;
+    ok      = started;
+}
+
+CRC_GZ_TRACE_READER::~CRC_GZ_TRACE_READER()
+{
+    Stop();
+
+    if( gz ) gzclose( gz );
+
+    for(UINT32 b=0; b<CRC_GZ_BUFFERS; b++) CRC_AlignedFree( pool[b] );
+
+    delete filled;
+    delete empty;
+}
+
+// Ends the inflate thread (at once if it waits for a buffer, else after the
+// one it is filling); no more records are returned afterwards
+void CRC_GZ_TRACE_READER::Stop()
+{
+    if( !started ) return;
+
+    __atomic_store_n( &stop, true, __ATOMIC_RELEASE );
+    pthread_join( thread, NULL );
+
+    started  = false;
+    finished = true;
+}
+
+void *CRC_GZ_TRACE_READER::InflateMain( void *arg )
+{
+    ((CRC_GZ_TRACE_READER *)arg)->Inflate();
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Inflate thread: fill free buffers until the end of the trace, then send    //
+// an empty chunk. A stream that ends early, a truncated last record and a    //
+// record count other than the header's all set readError.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_GZ_TRACE_READER::Inflate()
+{
+    UINT32 spins = 0;
+
+    while( true )
+    {
+        UINT32 b;
+        double waitStart = GzNow();
+
+        while( !empty->PopMany( &b, 1 ) )
+        {
+            if( __atomic_load_n( &stop, __ATOMIC_ACQUIRE ) ) return;
+            GzBackoff( spins );
+        }
+
+        double start = GzNow();
+        producerStall += start - waitStart;
+
+        int bytes = gzread( gz, pool[b], CRC_GZ_BUFFER_RECORDS * sizeof(Access) );
+        int errnum;
+
+        // a short read is either the end of the stream or, with Z_BUF_ERROR,
+        // a stream cut off before its end
+        if( bytes < (int)(CRC_GZ_BUFFER_RECORDS * sizeof(Access)) )
+        {
+            gzerror( gz, &errnum );
+
+            if( bytes < 0 || (errnum != Z_OK && errnum != Z_STREAM_END) || bytes % sizeof(Access) )
+            {
+                readError = true;
+            }
+
+            if( bytes < 0 ) bytes = 0;
+        }
+
+        CRC_GZ_CHUNK chunk;
+        chunk.buffer  = b;
+        chunk.records = bytes / sizeof(Access);
+
+        inflated    += chunk.records;
+        inflateBusy += GzNow() - start;
+
+        // the header tells how long the trace should have been
+        if( !chunk.records && inflated != header.records ) readError = true;
+
+        // the ring holds more chunks than there are buffers, so it never fills
+        filled->PushMany( &chunk, 1 );
+
+        if( !chunk.records ) return;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Simulation side: give back the previous buffer, wait for the next one      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+size_t CRC_GZ_TRACE_READER::Next( const Access *&records )
+{
+    records = NULL;
+
+    if( !ok || finished ) return 0;
+
+    if( holding )
+    {
+        empty->PushMany( &held, 1 );
+        holding = false;
+    }
+
+    CRC_GZ_CHUNK chunk;
+    UINT32       spins = 0;
+
+    if( !filled->PopMany( &chunk, 1 ) )
+    {
+        double waitStart = GzNow();
+
+        while( !filled->PopMany( &chunk, 1 ) ) GzBackoff( spins );
+
+        consumerStall += GzNow() - waitStart;
+    }
+
+    if( !chunk.records )
+    {
+        finished = true;
+        return 0;
+    }
+
+    holding   = true;
+    held      = chunk.buffer;
+    consumed += chunk.records;
+    records   = pool[ chunk.buffer ];
+
+    return chunk.records;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the throughput and stall time of both stages. elapsed  //
+// is the wall time of the whole replay on the simulation thread.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_GZ_TRACE_READER::PrintStats( ostream &out, double elapsed )
+{
+    // the inflate counters can only be read once the thread is gone
+    Stop();
+
+    double mb      = (double)inflated * sizeof(Access) / (1024 * 1024);
+    double simBusy = elapsed - consumerStall;
+
+    out<<"Trace Pipeline: "<<endl;
+    out<<endl;
+    out<<"\tBuffers:        "<<CRC_GZ_BUFFERS<<" x "<<CRC_GZ_BUFFER_RECORDS<<" records"<<endl;
+    out<<"\tInflate:        "<<inflated<<" records, "<<mb<<" MB in "<<inflateBusy<<" s busy ("
+       <<(inflateBusy > 0 ? mb / inflateBusy : 0)<<" MB/s, "
+       <<(COUNTER)(inflateBusy > 0 ? inflated / inflateBusy : 0)<<" records/s)"<<endl;
+    out<<"\tInflate Stall:  "<<producerStall<<" s waiting for a free buffer"<<endl;
+    out<<"\tSimulate:       "<<consumed<<" records handed over, "<<simBusy<<" s busy ("
+       <<(COUNTER)(simBusy > 0 ? consumed / simBusy : 0)<<" records/s)"<<endl;
+    out<<"\tSimulate Stall: "<<consumerStall<<" s waiting for inflated records"<<endl;
+    if( readError ) out<<"\tError:          the trace is corrupt or truncated"<<endl;
+    out<<endl;
+
+    return out;
+}
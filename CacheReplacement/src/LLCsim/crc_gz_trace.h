@@ -0,0 +1,99 @@
+#ifndef CRC_GZ_TRACE_H
+#define CRC_GZ_TRACE_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Pipelined reader for gzip-compressed traces (a CRCTRACE file, layout in    //
+// crc_trace.h, run through gzip).                                            //
+//                                                                            //
+// A dedicated thread inflates the trace into a fixed pool of buffers of      //
+// CRC_GZ_BUFFER_RECORDS records each. Filled buffers go to the simulation    //
+// thread through one lock-free SPSC ring and come back, once simulated,      //
+// through a second one, so inflation of the next buffers overlaps with the   //
+// simulation of the current one and no memory is allocated after start-up.   //
+//                                                                            //
+// Each side counts the time it spends waiting on the other: a busy inflate   //
+// thread that rarely stalls while the simulation thread often does means     //
+// decompression is the bottleneck, and the other way round.                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <zlib.h>
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_trace.h"
+#include "crc_spsc.h"
+
+// Buffers in the pool and records per buffer (1.5 MB)
+#define CRC_GZ_BUFFERS          8
+#define CRC_GZ_BUFFER_RECORDS   65536
+
+// A filled buffer; records == 0 marks the end of the trace
+typedef struct
+{
+    UINT32  buffer;
+    UINT32  records;
+} CRC_GZ_CHUNK;
+
+class CRC_GZ_TRACE_READER
+{
+  private:
+
+    gzFile            gz;
+    CRC_TRACE_HEADER  header;
+    bool              ok;
+
+    Access           *pool[ CRC_GZ_BUFFERS ];
+
+    CRC_SPSC_RING<CRC_GZ_CHUNK>  *filled;    // inflate thread -> simulation
+    CRC_SPSC_RING<UINT32>        *empty;     // simulation -> inflate thread
+
+    pthread_t  thread;
+    bool       started;
+    bool       stop;
+
+    // simulation side
+    bool     holding;       // a buffer is out with the caller
+    UINT32   held;
+    bool     finished;
+    COUNTER  consumed;
+    double   consumerStall;
+
+    // inflate side, on its own host cache line
+    char     pad[ CRC_HOST_LINE_SIZE ];
+    COUNTER  inflated;      // records
+    double   inflateBusy;
+    double   producerStall;
+    bool     readError;
+
+  public:
+
+    CRC_GZ_TRACE_READER( const char *path );
+    ~CRC_GZ_TRACE_READER();
+
+    // The next run of records, valid until the following call; returns 0 at
+    // the end of the trace
+    size_t  Next( const Access *&records );
+
+    bool    Ok() { return ok; }
+
+    // True when the trace is corrupt or holds fewer records than its header
+    // says; final once Next() has returned 0
+    bool    ReadError() { return finished && __atomic_load_n( &readError, __ATOMIC_ACQUIRE ); }
+    UINT32  Threads() { return header.threads; }
+    COUNTER NumRecords() { return header.records; }
+
+    // Per-stage report: inflate rate and busy time, stall time on both
+    // sides. Stops the inflate thread, so call it after the last Next().
+    ostream &   PrintStats( ostream &out, double elapsed );
+
+  private:
+
+    static void *InflateMain( void *arg );
+    void    Inflate();
+    void    Stop();
+
+};
+
+#endif
@@ -0,0 +1,345 @@
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include "crc_instrument.h"
+
+static const char *crc_probe_kinds[] = { "counter", "gauge", "histogram" };
+
+// Little-endian fixed-width integer of the series file header
+static bool PutFixed( FILE *fp, unsigned long long value, UINT32 bytes )
+{
+    unsigned char buf[8];
+
+    for(UINT32 i=0; i<bytes; i++) buf[i] = (unsigned char)(value >> (8 * i));
+
+    return fwrite( buf, 1, bytes, fp ) == bytes;
+}
+
+CRC_INSTRUMENTATION::CRC_INSTRUMENTATION( COUNTER _interval )
+{
+    interval    = _interval;
+    sinceSample = 0;
+    samples     = 0;
+    probes      = 0;
+    slots       = 0;
+    capacity    = 64;
+
+    values  = new long long[ capacity ];
+    sampled = new long long[ capacity ];
+
+    series         = NULL;
+    seriesBytes    = 0;
+    seriesCapacity = 0;
+}
+
+CRC_INSTRUMENTATION::~CRC_INSTRUMENTATION()
+{
+    for(UINT32 p=0; p<probes; p++) delete [] names[p];
+
+    delete [] values;
+    delete [] sampled;
+    delete [] series;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Probe registration; the value slots double when full                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+UINT32 CRC_INSTRUMENTATION::AddCounter( const char *name )
+{
+    return AddProbe( name, CRC_PROBE_COUNTER, 1 );
+}
+
+UINT32 CRC_INSTRUMENTATION::AddGauge( const char *name )
+{
+    return AddProbe( name, CRC_PROBE_GAUGE, 1 );
+}
+
+UINT32 CRC_INSTRUMENTATION::AddHistogram( const char *name, UINT32 _bins )
+{
+    return AddProbe( name, CRC_PROBE_HISTOGRAM, _bins );
+}
+
+UINT32 CRC_INSTRUMENTATION::AddProbe( const char *name, UINT32 kind, UINT32 _bins )
+{
+    assert( samples == 0 );
+    assert( probes < CRC_INSTRUMENT_MAX_PROBES );
+    assert( _bins >= 1 && _bins <= CRC_INSTRUMENT_MAX_BINS );
+    assert( !strpbrk( name, "\"\\" ) );
+
+    if( slots + _bins > capacity )
+    {
+        while( slots + _bins > capacity ) capacity *= 2;
+
+        long long *v = new long long[ capacity ];
+        long long *s = new long long[ capacity ];
+
+        memcpy( v, values, slots * sizeof(long long) );
+        memcpy( s, sampled, slots * sizeof(long long) );
+
+        delete [] values;
+        delete [] sampled;
+
+        values  = v;
+        sampled = s;
+    }
+
+    names[ probes ] = new char[ strlen( name ) + 1 ];
+    strcpy( names[ probes ], name );
+
+    kinds[ probes ] = kind;
+    bins[ probes ]  = _bins;
+    first[ probes ] = slots;
+
+    memset( &values[ slots ], 0, _bins * sizeof(long long) );
+    memset( &sampled[ slots ], 0, _bins * sizeof(long long) );
+    slots += _bins;
+
+    return probes++;
+}
+
+INT32 CRC_INSTRUMENTATION::Find( const char *name )
+{
+    for(UINT32 p=0; p<probes; p++)
+    {
+        if( !strcmp( names[p], name ) ) return p;
+    }
+
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A sample: every slot as a zigzag varint of its change since the last one   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_INSTRUMENTATION::Sample()
+{
+    // a varint of a 64-bit value takes at most 10 bytes
+    if( seriesBytes + 10 * (size_t)slots > seriesCapacity )
+    {
+        size_t         size = seriesCapacity ? 2 * seriesCapacity : 4096;
+        unsigned char *grown;
+
+        while( seriesBytes + 10 * (size_t)slots > size ) size *= 2;
+
+        grown = new unsigned char[ size ];
+        if( seriesBytes ) memcpy( grown, series, seriesBytes );
+
+        delete [] series;
+
+        series         = grown;
+        seriesCapacity = size;
+    }
+
+    for(UINT32 s=0; s<slots; s++)
+    {
+        PutVarint( values[s] - sampled[s] );
+        sampled[s] = values[s];
+    }
+
+    samples++;
+    sinceSample = 0;
+}
+
+void CRC_INSTRUMENTATION::PutVarint( long long delta )
+{
+    unsigned long long zigzag = ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63);
+
+    while( zigzag >= 0x80 )
+    {
+        series[ seriesBytes++ ] = (unsigned char)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+
+    series[ seriesBytes++ ] = (unsigned char)zigzag;
+}
+
+long long CRC_INSTRUMENTATION::GetVarint( const unsigned char *&p )
+{
+    unsigned long long zigzag = 0;
+    UINT32             shift  = 0;
+
+    do
+    {
+        zigzag |= (unsigned long long)(*p & 0x7f) << shift;
+        shift  += 7;
+    } while( *p++ & 0x80 );
+
+    return (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function writes the series file (layout in crc_instrument.h)           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_INSTRUMENTATION::WriteSeries( const char *path )
+{
+    FILE *fp = fopen( path, "wb" );
+
+    if( !fp ) return false;
+
+    bool ok = fwrite( "CRCI", 1, 4, fp ) == 4 && PutFixed( fp, CRC_INSTRUMENT_VERSION, 4 ) &&
+              PutFixed( fp, interval, 8 ) && PutFixed( fp, probes, 4 );
+
+    for(UINT32 p=0; ok && p<probes; p++)
+    {
+        ok = PutFixed( fp, kinds[p], 1 ) && PutFixed( fp, bins[p], 4 ) &&
+             fwrite( names[p], 1, strlen( names[p] ) + 1, fp ) == strlen( names[p] ) + 1;
+    }
+
+    ok = ok && PutFixed( fp, samples, 8 ) && fwrite( series, 1, seriesBytes, fp ) == seriesBytes;
+
+    return (fclose( fp ) == 0) && ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the final value of every probe: the total of each      //
+// counter, the value of each gauge with its range over the samples, and the  //
+// share of each histogram bin with the mean bin                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_INSTRUMENTATION::PrintStats( ostream &out )
+{
+    long long *low  = new long long[ probes ];
+    long long *high = new long long[ probes ];
+    long long *now  = new long long[ slots ];
+
+    // the gauge ranges come from the series
+    const unsigned char *p = series;
+
+    memset( now, 0, slots * sizeof(long long) );
+
+    for(COUNTER k=0; k<samples; k++)
+    {
+        for(UINT32 s=0; s<slots; s++) now[s] += GetVarint( p );
+
+        for(UINT32 g=0; g<probes; g++)
+        {
+            long long v = now[ first[g] ];
+
+            if( !k || v < low[g] ) low[g] = v;
+            if( !k || v > high[g] ) high[g] = v;
+        }
+    }
+
+    out<<"Instrumentation: "<<endl;
+    out<<endl;
+    out<<"\tSamples:         "<<samples<<" every "<<interval<<" accesses, "<<seriesBytes<<" bytes ("
+       <<(samples ? (double)seriesBytes / samples : 0)<<" per sample)"<<endl;
+
+    for(UINT32 g=0; g<probes; g++)
+    {
+        long long *v = &values[ first[g] ];
+
+        out<<"\t"<<names[g]<<": ";
+
+        if( kinds[g] == CRC_PROBE_COUNTER ) out<<v[0];
+
+        if( kinds[g] == CRC_PROBE_GAUGE )
+        {
+            out<<v[0];
+            if( samples ) out<<" (sampled "<<low[g]<<" .. "<<high[g]<<")";
+        }
+
+        if( kinds[g] == CRC_PROBE_HISTOGRAM )
+        {
+            long long total = 0;
+            double    mean  = 0;
+
+            for(UINT32 b=0; b<bins[g]; b++)
+            {
+                total += v[b];
+                mean  += (double)b * v[b];
+            }
+
+            out<<total<<" mean "<<(total ? mean / total : 0)<<" |";
+
+            for(UINT32 b=0; b<bins[g]; b++)
+            {
+                out<<" "<<b<<": "<<(total ? 100.0 * v[b] / total : 0)<<"%";
+            }
+        }
+
+        out<<endl;
+    }
+
+    out<<endl;
+
+    delete [] low;
+    delete [] high;
+    delete [] now;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints every probe as JSON: its kind, final value (totals     //
+// per bin for histograms) and series, per sample the change of a counter or  //
+// bin during the interval and the value of a gauge                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_INSTRUMENTATION::PrintJSON( ostream &out )
+{
+    long long *decoded = new long long[ samples * slots + 1 ];
+    long long *now     = new long long[ slots ];
+
+    const unsigned char *p = series;
+
+    memset( now, 0, slots * sizeof(long long) );
+
+    for(COUNTER k=0; k<samples; k++)
+    {
+        for(UINT32 s=0; s<slots; s++)
+        {
+            long long delta = GetVarint( p );
+
+            now[s] += delta;
+            decoded[ k * slots + s ] = delta;
+        }
+
+        for(UINT32 g=0; g<probes; g++)
+        {
+            if( kinds[g] == CRC_PROBE_GAUGE ) decoded[ k * slots + first[g] ] = now[ first[g] ];
+        }
+    }
+
+    out<<"{\n  \"interval\": "<<interval<<",\n  \"samples\": "<<samples<<",\n  \"probes\": [";
+
+    for(UINT32 g=0; g<probes; g++)
+    {
+        out<<(g ? "," : "")<<"\n    { \"name\": \""<<names[g]<<"\", \"kind\": \""<<crc_probe_kinds[ kinds[g] ]<<"\", ";
+
+        if( kinds[g] == CRC_PROBE_HISTOGRAM )
+        {
+            out<<"\"bins\": [";
+            for(UINT32 b=0; b<bins[g]; b++) out<<(b ? ", " : "")<<values[ first[g] + b ];
+            out<<"],\n      \"series\": [";
+
+            for(COUNTER k=0; k<samples; k++)
+            {
+                out<<(k ? ", " : "")<<"[";
+                for(UINT32 b=0; b<bins[g]; b++) out<<(b ? ", " : "")<<decoded[ k * slots + first[g] + b ];
+                out<<"]";
+            }
+        }
+        else
+        {
+            out<<"\"value\": "<<values[ first[g] ]<<",\n      \"series\": [";
+            for(COUNTER k=0; k<samples; k++) out<<(k ? ", " : "")<<decoded[ k * slots + first[g] ];
+        }
+
+        out<<"] }";
+    }
+
+    out<<"\n  ]\n}\n";
+
+    delete [] decoded;
+    delete [] now;
+
+    return out;
+}
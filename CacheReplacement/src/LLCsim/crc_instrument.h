@@ -0,0 +1,120 @@
+#ifndef CRC_INSTRUMENT_H
+#define CRC_INSTRUMENT_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Instrumentation of the replacement policies.                               //
+//                                                                            //
+// A policy registers named probes: counters (events), gauges (a value such   //
+// as a PSEL counter, set when sampled) and histograms (counts per bin, the   //
+// last bin also holding everything above it). Every `interval` accesses      //
+// the values of all probes are appended to a compact binary time series,     //
+// which PrintStats summarizes, PrintJSON prints in full and WriteSeries      //
+// writes to a file.                                                          //
+//                                                                            //
+// The probes of CRC_CACHE and CACHE_REPLACEMENT_STATE are only compiled in   //
+// with CRC_INSTRUMENT defined (make CMDLINE=-DCRC_INSTRUMENT=1). Without it  //
+// the access path has no instrumentation code at all.                        //
+//                                                                            //
+// Series file, all integers little endian:                                   //
+//                                                                            //
+//   "CRCI", u32 version (1), u64 interval, u32 probes                        //
+//   per probe: u8 kind, u32 bins, name ending in a NUL                       //
+//   u64 samples, then per sample one varint per bin of every probe           //
+//                                                                            //
+// A counter or histogram bin is stored as its change since the previous      //
+// sample, a gauge as its value minus the previous one, both zigzag-coded     //
+// LEB128 varints: a bin that did not move costs one byte.                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+
+#ifdef CRC_INSTRUMENT
+#define CRC_INSTRUMENT_BUILT 1
+#else
+#define CRC_INSTRUMENT_BUILT 0
+#endif
+
+#define CRC_INSTRUMENT_MAX_PROBES   128
+#define CRC_INSTRUMENT_MAX_BINS     256
+#define CRC_INSTRUMENT_VERSION      1
+
+typedef enum
+{
+    CRC_PROBE_COUNTER   = 0,
+    CRC_PROBE_GAUGE     = 1,
+    CRC_PROBE_HISTOGRAM = 2
+} CrcProbeKind;
+
+class CRC_INSTRUMENTATION
+{
+  private:
+
+    COUNTER     interval;
+    COUNTER     sinceSample;
+    COUNTER     samples;
+
+    UINT32      probes;
+    char       *names[ CRC_INSTRUMENT_MAX_PROBES ];
+    UINT32      kinds[ CRC_INSTRUMENT_MAX_PROBES ];
+    UINT32      bins[ CRC_INSTRUMENT_MAX_PROBES ];
+    UINT32      first[ CRC_INSTRUMENT_MAX_PROBES ];    // first value slot
+
+    // one slot per counter and gauge and per histogram bin: the current
+    // value and the value at the last sample
+    UINT32      slots;
+    UINT32      capacity;
+    long long  *values;
+    long long  *sampled;
+
+    unsigned char *series;
+    size_t      seriesBytes;
+    size_t      seriesCapacity;
+
+  public:
+
+    // Sample every interval accesses (0: never)
+    CRC_INSTRUMENTATION( COUNTER _interval );
+    ~CRC_INSTRUMENTATION();
+
+    // Register a probe; returns its id. Names are copied and must not need
+    // escaping in JSON. Only before the first sample.
+    UINT32  AddCounter( const char *name );
+    UINT32  AddGauge( const char *name );
+    UINT32  AddHistogram( const char *name, UINT32 _bins );
+
+    void    Count( UINT32 probe, COUNTER n = 1 ) { values[ first[ probe ] ] += n; }
+    void    Set( UINT32 probe, long long value ) { values[ first[ probe ] ] = value; }
+    void    Record( UINT32 probe, UINT32 bin )
+    {
+        values[ first[ probe ] + ((bin < bins[ probe ]) ? bin : bins[ probe ] - 1) ]++;
+    }
+
+    // One access: true when a sample is due; the caller sets its gauges
+    // and calls Sample
+    bool    Tick() { return ++sinceSample == interval; }
+    void    Sample();
+
+    COUNTER Interval() { return interval; }
+    COUNTER Samples() { return samples; }
+    size_t  SeriesBytes() { return seriesBytes; }
+    long long Value( UINT32 probe, UINT32 bin = 0 ) { return values[ first[ probe ] + bin ]; }
+
+    // The probe of that name, or -1
+    INT32   Find( const char *name );
+    UINT32  Bins( UINT32 probe ) { return bins[ probe ]; }
+
+    bool    WriteSeries( const char *path );
+
+    ostream &   PrintStats( ostream &out );
+    ostream &   PrintJSON( ostream &out );
+
+  private:
+
+    UINT32  AddProbe( const char *name, UINT32 kind, UINT32 _bins );
+    void    PutVarint( long long delta );
+    static long long GetVarint( const unsigned char *&p );
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "crc_next_use.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Fingerprint: FNV-1a over the first and last CRC_NEXT_USE_PRINT_BYTES of    //
+// the file (the whole file if it is shorter than both)                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_NextUseFingerprint( const char *tracePath, COUNTER &traceBytes, unsigned long long &traceHash )
+{
+    int fd = open( tracePath, O_RDONLY );
+    if( fd < 0 ) return false;
+
+    struct stat st;
+    bool        ok = fstat( fd, &st ) == 0;
+
+    unsigned char *buf = new unsigned char[ CRC_NEXT_USE_PRINT_BYTES ];
+
+    traceBytes = ok ? st.st_size : 0;
+    traceHash  = 14695981039346656037ULL;
+
+    for(UINT32 end=0; ok && end<2; end++)
+    {
+        off_t  offset = 0;
+        size_t bytes  = (traceBytes < CRC_NEXT_USE_PRINT_BYTES) ? traceBytes : CRC_NEXT_USE_PRINT_BYTES;
+
+        if( end )
+        {
+            // the tail starts after the head, so no byte is hashed twice
+            if( traceBytes <= CRC_NEXT_USE_PRINT_BYTES ) break;
+
+            offset = traceBytes - bytes;
+            if( offset < CRC_NEXT_USE_PRINT_BYTES )
+            {
+                offset = CRC_NEXT_USE_PRINT_BYTES;
+                bytes  = traceBytes - offset;
+            }
+        }
+
+        ok = pread( fd, buf, bytes, offset ) == (ssize_t)bytes;
+
+        for(size_t b=0; ok && b<bytes; b++)
+        {
+            traceHash ^= buf[b];
+            traceHash *= 1099511628211ULL;
+        }
+    }
+
+    delete [] buf;
+    close( fd );
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Builder: the file is sized for every entry up front and mapped shared;     //
+// the kernel writes pages back as they are dirtied                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_NEXT_USE_BUILDER::CRC_NEXT_USE_BUILDER( const char *path, COUNTER _records, UINT32 linesize,
+                                            COUNTER traceBytes, unsigned long long traceHash )
+{
+    base      = NULL;
+    entries   = NULL;
+    records   = _records;
+    position  = 0;
+    lineShift = CRC_FloorLog2( linesize );
+    length    = sizeof(CRC_NEXT_USE_HEADER) + records * sizeof(unsigned long long);
+    ok        = false;
+
+    int fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 ) return;
+
+    if( ftruncate( fd, length ) == 0 )
+    {
+        base = mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if( base == MAP_FAILED ) base = NULL;
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    close( fd );
+
+    if( !base ) return;
+
+    CRC_NEXT_USE_HEADER header;
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, CRC_NEXT_USE_MAGIC, sizeof(header.magic) );
+    header.version    = CRC_NEXT_USE_VERSION;
+    header.linesize   = linesize;
+    header.records    = records;
+    header.traceBytes = traceBytes;
+    header.traceHash  = traceHash;
+
+    memcpy( base, &header, sizeof(header) );
+
+    entries = (unsigned long long *)( (char *)base + sizeof(header) );
+    ok      = true;
+}
+
+CRC_NEXT_USE_BUILDER::~CRC_NEXT_USE_BUILDER()
+{
+    if( base ) munmap( base, length );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// An access that is not a writeback resolves every pending access of its     //
+// line to itself and becomes the only pending one; a writeback joins the     //
+// chain                                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_NEXT_USE_BUILDER::Add( const Access *refs, size_t n )
+{
+    if( !ok ) return;
+
+    if( n > records - position )
+    {
+        ok = false;
+        return;
+    }
+
+    for(size_t r=0; r<n; r++)
+    {
+        Addr_t   line = refs[r].paddr >> lineShift;
+        COUNTER  i    = position++;
+        COUNTER *head = pending.Find( line );
+        COUNTER  link = head ? *head : 0;
+
+        if( refs[r].accessType != ACCESS_WRITEBACK )
+        {
+            while( link )
+            {
+                COUNTER k = link - 1;
+
+                link       = entries[k];
+                entries[k] = i + 1;
+            }
+        }
+
+        entries[i] = link;
+        pending.Set( line, i + 1 );
+    }
+}
+
+bool CRC_NEXT_USE_BUILDER::Finish()
+{
+    if( !ok || position != records )
+    {
+        ok = false;
+        return false;
+    }
+
+    // a pending entry links to an earlier access (or is 0), a resolved one
+    // to a later access
+    for(COUNTER k=0; k<records; k++)
+    {
+        if( entries[k] <= k ) entries[k] = 0;
+    }
+
+    ok = msync( base, length, MS_SYNC ) == 0;
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Mapping: read-only, and read front to back by the OPT policies             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_NEXT_USE_MAP::CRC_NEXT_USE_MAP( const char *path )
+{
+    memset( &header, 0, sizeof(header) );
+
+    base   = NULL;
+    length = 0;
+    ok     = false;
+
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 ) return;
+
+    struct stat st;
+
+    if( fstat( fd, &st ) == 0 && (size_t)st.st_size >= sizeof(header) )
+    {
+        length = st.st_size;
+        base   = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if( base == MAP_FAILED )
+        {
+            base   = NULL;
+            length = 0;
+        }
+    }
+
+    close( fd );
+
+    if( !base ) return;
+
+    madvise( base, length, MADV_SEQUENTIAL );
+
+    memcpy( &header, base, sizeof(header) );
+
+    // an index cut short would give wrong answers, not just fewer of them
+    ok = !memcmp( header.magic, CRC_NEXT_USE_MAGIC, sizeof(header.magic) )
+            && header.version == CRC_NEXT_USE_VERSION
+            && (length - sizeof(header)) / sizeof(unsigned long long) >= header.records;
+
+    if( !ok ) header.records = 0;
+}
+
+CRC_NEXT_USE_MAP::~CRC_NEXT_USE_MAP()
+{
+    if( base ) munmap( base, length );
+}
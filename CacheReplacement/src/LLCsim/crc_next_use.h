@@ -0,0 +1,120 @@
+#ifndef CRC_NEXT_USE_H
+#define CRC_NEXT_USE_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Next-use index of a trace, for the Belady OPT policies (CRC_REPL_OPT and   //
+// CRC_REPL_OPT_BYPASS).                                                      //
+//                                                                            //
+// Entry i is 1 + the position of the next access to the line of access i,    //
+// or 0 if the line is never accessed again. Writebacks do not count as a     //
+// next use: CRC_CACHE does not update the replacement state on a writeback   //
+// hit, so the entries of an access and of the writebacks that follow it all  //
+// point to the next access that is not a writeback.                          //
+//                                                                            //
+// The index is built in one forward pass and lives in a file mapped shared,  //
+// so only the pages being written stay resident and traces larger than       //
+// memory work. The only in-memory state is one entry per distinct line.      //
+// Until a line is used again, the entries of its pending accesses hold a     //
+// chain of links back through those accesses, all smaller than their own     //
+// position, which tells them apart from resolved entries; Finish() clears    //
+// the chains of lines that are never used again.                             //
+//                                                                            //
+// The header holds a fingerprint of the trace file the index was built       //
+// from: its size and a hash of its first and last CRC_NEXT_USE_PRINT_BYTES   //
+// bytes. That covers the trace header and, for a gzip trace, the trailer     //
+// with the CRC of the whole inflated trace, so an index is not reused for    //
+// another trace of the same length.                                          //
+//                                                                            //
+//   offset  size  header                                                     //
+//        0     8  magic "CRCNEXTU"                                           //
+//        8     4  version (2)                                                //
+//       12     4  line size                                                  //
+//       16     8  records                                                    //
+//       24     8  trace file size                                            //
+//       32     8  trace file hash (FNV-1a)                                   //
+//                                                                            //
+//   40 + 8 * i    entry i                                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_stack_dist.h"
+
+#define CRC_NEXT_USE_MAGIC    "CRCNEXTU"
+#define CRC_NEXT_USE_VERSION  2
+
+// Bytes hashed at each end of the trace file
+#define CRC_NEXT_USE_PRINT_BYTES  65536
+
+typedef struct
+{
+    char                magic[8];    // CRC_NEXT_USE_MAGIC
+    UINT32              version;     // CRC_NEXT_USE_VERSION
+    UINT32              linesize;
+    COUNTER             records;
+    COUNTER             traceBytes;
+    unsigned long long  traceHash;
+} CRC_NEXT_USE_HEADER;
+
+// Fingerprint of a trace file; false if it cannot be read
+bool CRC_NextUseFingerprint( const char *tracePath, COUNTER &traceBytes, unsigned long long &traceHash );
+
+// Writes the index of a trace of known length, fed front to back
+class CRC_NEXT_USE_BUILDER
+{
+  private:
+
+    void                 *base;
+    size_t                length;
+    unsigned long long   *entries;
+    COUNTER               records;
+    COUNTER               position;
+    UINT32                lineShift;
+    bool                  ok;
+
+    CRC_LINE_MAP          pending;  // line -> 1 + its last pending access
+
+  public:
+
+    CRC_NEXT_USE_BUILDER( const char *path, COUNTER _records, UINT32 linesize,
+                          COUNTER traceBytes, unsigned long long traceHash );
+    ~CRC_NEXT_USE_BUILDER();
+
+    void    Add( const Access *refs, size_t n );
+
+    // Close the chains of lines never used again and flush the file;
+    // returns false on any error or if fewer records came than announced
+    bool    Finish();
+
+    bool    Ok() { return ok; }
+
+};
+
+// Read-only mapping of a next-use index
+class CRC_NEXT_USE_MAP
+{
+  private:
+
+    void                 *base;
+    size_t                length;
+    CRC_NEXT_USE_HEADER   header;
+    bool                  ok;
+
+  public:
+
+    CRC_NEXT_USE_MAP( const char *path );
+    ~CRC_NEXT_USE_MAP();
+
+    const unsigned long long *Entries() { return ok ? (const unsigned long long *)( (const char *)base + sizeof(header) ) : NULL; }
+
+    bool    Ok() { return ok; }
+    UINT32  LineSize() { return header.linesize; }
+    COUNTER NumRecords() { return header.records; }
+    COUNTER TraceBytes() { return header.traceBytes; }
+    unsigned long long TraceHash() { return header.traceHash; }
+
+};
+
+#endif
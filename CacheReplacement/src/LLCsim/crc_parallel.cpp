@@ -0,0 +1,338 @@
+#include <pthread.h>
+#include <sched.h>
+#include "crc_parallel.h"
+#include "crc_spsc.h"
+
+// Polls of an empty (or full) ring before a waiting thread yields its core
+#define CRC_PARALLEL_SPIN 64
+
+struct CRC_PARALLEL_WORKER
+{
+    CRC_CACHE              *shard;
+    CRC_SPSC_RING<Access>  *ring;
+    pthread_t               thread;
+
+    // router side
+    Access   stage[ CRC_PARALLEL_RUN ];
+    size_t   staged;
+    COUNTER  routed;
+
+    // worker side, on its own host cache line
+    char     pad[ CRC_HOST_LINE_SIZE ];
+    COUNTER  done;
+    bool     stop;
+};
+
+static inline void ParallelBackoff( UINT32 &spins )
+{
+    if( ++spins > CRC_PARALLEL_SPIN )
+    {
+        sched_yield();
+        spins = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Worker thread: replay the ring through the shard until told to stop        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static void *ParallelWorkerMain( void *arg )
+{
+    CRC_PARALLEL_WORKER *w = (CRC_PARALLEL_WORKER *)arg;
+    Access  run[ CRC_PARALLEL_RUN ];
+    UINT32  spins = 0;
+
+    while( true )
+    {
+        size_t n = w->ring->PopMany( run, CRC_PARALLEL_RUN );
+
+        if( n )
+        {
+            w->shard->LookupAndFillBatch( run, n, NULL );
+            __atomic_store_n( &w->done, w->done + n, __ATOMIC_RELEASE );
+            spins = 0;
+            continue;
+        }
+
+        // the engine drains every ring before it raises stop
+        if( __atomic_load_n( &w->stop, __ATOMIC_ACQUIRE ) ) break;
+
+        ParallelBackoff( spins );
+    }
+
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor creates one shard, ring and thread per worker              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_PARALLEL_CACHE::CRC_PARALLEL_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                                        UINT32 _workers, UINT32 _mode )
+{
+    assert( _workers >= 1 && _workers <= CRC_PARALLEL_MAX_WORKERS && !(_workers & (_workers - 1)) );
+    assert( _mode == CRC_SYNC_APPROX || _mode == CRC_SYNC_RELAXED );
+
+    // a shard cannot tell the trace position of an access (see above)
+    assert( _pol != CRC_REPL_OPT && _pol != CRC_REPL_OPT_BYPASS );
+
+    numWorkers = _workers;
+    syncMode   = _mode;
+    threads    = _tpc;
+
+    lineShift  = CRC_FloorLog2( _linesize );
+    indexMask  = (1 << CRC_FloorLog2( _cacheSize / (_linesize * _assoc) )) - 1;
+
+    sinceSync  = 0;
+    epochs     = 0;
+
+    workers = new CRC_PARALLEL_WORKER* [ numWorkers ];
+
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        CRC_PARALLEL_WORKER *w = new CRC_PARALLEL_WORKER;
+
+        w->shard  = new CRC_CACHE( _cacheSize, _assoc, _tpc, _linesize, _pol, numWorkers, i );
+        w->ring   = new CRC_SPSC_RING<Access>( CRC_PARALLEL_RING );
+        w->staged = 0;
+        w->routed = 0;
+        w->done   = 0;
+        w->stop   = false;
+
+        workers[i] = w;
+    }
+
+    CRC_SET_DUELING *duel = workers[0]->shard->ReplacementState()->Dueling();
+
+    globalCounters = duel ? duel->NumCounters() : 0;
+    globalCounter  = new UINT32[ globalCounters ];
+
+    for(UINT32 c=0; c<globalCounters; c++) globalCounter[c] = duel->GetCounter( c );
+
+    CRC_PREDICTOR_TABLE table = workers[0]->shard->ReplacementState()->Predictor();
+
+    globalEntries = table.size;
+    globalEntry   = new int[ globalEntries ];
+
+    for(size_t e=0; e<globalEntries; e++)
+    {
+        globalEntry[e] = table.isSigned ? (signed char)table.entries[e] : (table.entries[e] & ~table.flags);
+    }
+
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        int err = pthread_create( &workers[i]->thread, NULL, ParallelWorkerMain, workers[i] );
+
+        // ensure that we were able to start the worker
+        assert( err == 0 );
+        (void)err;
+    }
+}
+
+CRC_PARALLEL_CACHE::~CRC_PARALLEL_CACHE()
+{
+    Drain();
+
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        __atomic_store_n( &workers[i]->stop, true, __ATOMIC_RELEASE );
+    }
+
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        pthread_join( workers[i]->thread, NULL );
+
+        delete workers[i]->shard;
+        delete workers[i]->ring;
+        delete workers[i];
+    }
+
+    delete [] workers;
+    delete [] globalCounter;
+    delete [] globalEntry;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function hands each access to the worker owning its set. In            //
+// approximate mode it stops every CRC_PARALLEL_EPOCH accesses to merge the   //
+// global policy state.                                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_PARALLEL_CACHE::LookupAndFillBatch( const Access *reqs, size_t n )
+{
+    for(size_t i=0; i<n; i++)
+    {
+        CRC_PARALLEL_WORKER *w = workers[ GetWorker( reqs[i].paddr ) ];
+
+        w->stage[ w->staged++ ] = reqs[i];
+
+        if( w->staged == CRC_PARALLEL_RUN )
+        {
+            Flush( w );
+        }
+
+        if( syncMode == CRC_SYNC_APPROX && ++sinceSync == CRC_PARALLEL_EPOCH )
+        {
+            WaitIdle();
+            MergeGlobalState();
+        }
+    }
+}
+
+void CRC_PARALLEL_CACHE::Drain()
+{
+    WaitIdle();
+
+    if( syncMode == CRC_SYNC_APPROX && sinceSync )
+    {
+        MergeGlobalState();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function pushes the accesses staged for a worker into its ring,        //
+// waiting for room if the worker is behind                                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_PARALLEL_CACHE::Flush( CRC_PARALLEL_WORKER *w )
+{
+    size_t pushed = 0;
+    UINT32 spins  = 0;
+
+    while( pushed < w->staged )
+    {
+        size_t n = w->ring->PushMany( w->stage + pushed, w->staged - pushed );
+
+        if( n == 0 ) ParallelBackoff( spins );
+        pushed += n;
+    }
+
+    w->routed += w->staged;
+    w->staged  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function flushes every worker and waits until all of them have         //
+// simulated everything routed to them                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_PARALLEL_CACHE::WaitIdle()
+{
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        Flush( workers[i] );
+    }
+
+    for(UINT32 i=0; i<numWorkers; i++)
+    {
+        UINT32 spins = 0;
+
+        while( __atomic_load_n( &workers[i]->done, __ATOMIC_ACQUIRE ) != workers[i]->routed )
+        {
+            ParallelBackoff( spins );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function folds the movement of every set dueling counter and           //
+// predictor entry in every shard since the last merge into the global value  //
+// and hands the result back to all shards. Only called while the workers are //
+// idle.                                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_PARALLEL_CACHE::MergeGlobalState()
+{
+    for(UINT32 c=0; c<globalCounters; c++)
+    {
+        long long value = globalCounter[c];
+        long long max   = workers[0]->shard->ReplacementState()->Dueling()->CounterMax();
+
+        for(UINT32 i=0; i<numWorkers; i++)
+        {
+            value += (long long)workers[i]->shard->ReplacementState()->Dueling()->GetCounter( c ) - globalCounter[c];
+        }
+
+        globalCounter[c] = (value < 0) ? 0 : ((value > max) ? max : value);
+
+        for(UINT32 i=0; i<numWorkers; i++)
+        {
+            workers[i]->shard->ReplacementState()->Dueling()->SetCounter( c, globalCounter[c] );
+        }
+    }
+
+    if( globalEntries ) MergePredictor();
+
+    sinceSync = 0;
+    epochs++;
+}
+
+// Same for the predictor entries; flag bits are or-ed across the shards
+void CRC_PARALLEL_CACHE::MergePredictor()
+{
+    CRC_PREDICTOR_TABLE table[ CRC_PARALLEL_MAX_WORKERS ];
+
+    for(UINT32 i=0; i<numWorkers; i++) table[i] = workers[i]->shard->ReplacementState()->Predictor();
+
+    for(size_t e=0; e<globalEntries; e++)
+    {
+        long long     value = globalEntry[e];
+        unsigned char flags = 0;
+
+        for(UINT32 i=0; i<numWorkers; i++)
+        {
+            unsigned char entry = table[i].entries[e];
+
+            if( table[i].isSigned ) value += (signed char)entry - globalEntry[e];
+            else                    value += (entry & ~table[i].flags) - globalEntry[e];
+
+            flags |= entry & table[i].flags;
+        }
+
+        globalEntry[e] = (value < table[0].min) ? table[0].min : ((value > table[0].max) ? table[0].max : value);
+
+        for(UINT32 i=0; i<numWorkers; i++)
+        {
+            table[i].entries[e] = (unsigned char)globalEntry[e] | flags;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Statistics: sums over the shards                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+COUNTER CRC_PARALLEL_CACHE::ThreadDemandLookupStats( UINT32 tid )
+{
+    COUNTER stat = 0;
+    for(UINT32 i=0; i<numWorkers; i++) stat += workers[i]->shard->ThreadDemandLookupStats( tid );
+    return stat;
+}
+
+COUNTER CRC_PARALLEL_CACHE::ThreadDemandMissStats( UINT32 tid )
+{
+    COUNTER stat = 0;
+    for(UINT32 i=0; i<numWorkers; i++) stat += workers[i]->shard->ThreadDemandMissStats( tid );
+    return stat;
+}
+
+COUNTER CRC_PARALLEL_CACHE::ThreadDemandHitStats( UINT32 tid )
+{
+    COUNTER stat = 0;
+    for(UINT32 i=0; i<numWorkers; i++) stat += workers[i]->shard->ThreadDemandHitStats( tid );
+    return stat;
+}
+
+COUNTER CRC_PARALLEL_CACHE::DirtyEvictionStats()
+{
+    COUNTER stat = 0;
+    for(UINT32 i=0; i<numWorkers; i++) stat += workers[i]->shard->DirtyEvictionStats();
+    return stat;
+}
@@ -0,0 +1,141 @@
+#ifndef CRC_PARALLEL_H
+#define CRC_PARALLEL_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Set-sharded parallel simulation engine for CRC_CACHE.                      //
+//                                                                            //
+// The sets of the cache are split over N worker threads, N a power of two:   //
+// set s belongs to worker s % N. Each worker drives its own CRC_CACHE shard  //
+// holding only the sets it owns, global set s being its local set s / N, so  //
+// the tag store and replacement state are split N ways too. The leader and   //
+// sampled sets of the policies are still placed by the global set index,     //
+// as in a single cache. The calling thread routes every access to the        //
+// owner's lock-free SPSC ring; the workers replay their rings through        //
+// LookupAndFillBatch. Accesses to one set are therefore seen in trace order. //
+//                                                                            //
+// Most policy state is per set and splits cleanly. The state shared across   //
+// sets is, per policy:                                                       //
+//                                                                            //
+//   DRRIP        the set dueling selector of each thread                     //
+//                (crc_set_dueling.h)                                         //
+//   SHiP         the SHCT                                                    //
+//   Hawkeye      the PC predictor (OPTgen runs per sampled set)              //
+//   SDBP         the predictor tables (the sampler is per sampled set)       //
+//   Perceptron   the weight tables, and the PC history of each thread        //
+//   EAF          the Bloom filter of evicted addresses                       //
+//                                                                            //
+// The selectors and the predictor tables are merged as below. The rest stays //
+// per shard. EAF filters only the addresses of the shard's own sets, sized   //
+// and cleared by its own lines, so each shard holds one slice of a           //
+// partitioned filter. A perceptron thread's PC history only holds its PCs    //
+// among accesses to the shard's sets. Neither mode below is exact for these  //
+// policies with more than one worker; both are approximations:               //
+//                                                                            //
+//   CRC_SYNC_APPROX   every CRC_PARALLEL_EPOCH accesses all workers drain,   //
+//                     the movements of each selector counter and predictor   //
+//                     entry in all shards are summed into one global value   //
+//                     (clamped to its range) and every shard restarts from   //
+//                     it. Followers see the selectors, and predictions use   //
+//                     the other shards' training, as of the last epoch       //
+//                     boundary. With one worker, and for policies without    //
+//                     global state (LRU, tree-PLRU, NRU), results are        //
+//                     identical to the sequential CRC_CACHE.                 //
+//                                                                            //
+//   CRC_SYNC_RELAXED  no synchronization: each shard trains its own          //
+//                     selectors and predictor only from the sets it owns.    //
+//                     Nothing ever stalls, but the miss rate drifts further. //
+//                                                                            //
+// An exact mode would need more than syncs at every training event:          //
+// Random replacement and BRRIP draw from a per-instance random stream, so    //
+// with more than one worker they draw different numbers than a single cache  //
+// would and only agree with it statistically. crc_bench parallel reports     //
+// the deviation from the sequential run and fails past a bound.              //
+//                                                                            //
+// OPT and OPT with bypass cannot be sharded: they read the next-use index    //
+// by the position of the access in the whole trace, which a shard does not   //
+// know.                                                                      //
+//                                                                            //
+// Statistics are only meaningful after Drain().                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_cache.h"
+
+// Accesses between two merges of the global policy state in approximate mode
+#define CRC_PARALLEL_EPOCH       65536
+
+// Records per worker ring, and per run staged by the router / popped by a worker
+#define CRC_PARALLEL_RING        16384
+#define CRC_PARALLEL_RUN         256
+
+#define CRC_PARALLEL_MAX_WORKERS 256
+
+typedef enum
+{
+    CRC_SYNC_APPROX  = 0,
+    CRC_SYNC_RELAXED = 1
+} ParallelSyncMode;
+
+struct CRC_PARALLEL_WORKER;
+
+class CRC_PARALLEL_CACHE
+{
+  private:
+
+    UINT32 numWorkers;
+    UINT32 syncMode;
+    UINT32 threads;
+
+    // Lookup Parameters
+    UINT32 lineShift;
+    UINT32 indexMask;
+
+    CRC_PARALLEL_WORKER **workers;
+
+    // approximate mode: accesses routed since the last merge, the merged
+    // set dueling counters and the merged predictor entries
+    COUNTER sinceSync;
+    COUNTER epochs;
+    UINT32  globalCounters;
+    UINT32 *globalCounter;
+    size_t  globalEntries;
+    int    *globalEntry;
+
+  public:
+
+    CRC_PARALLEL_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _tpc, UINT32 _linesize, UINT32 _pol,
+                        UINT32 _workers, UINT32 _mode=CRC_SYNC_APPROX );
+    ~CRC_PARALLEL_CACHE();
+
+    // Route a batch of accesses to the workers. Returns once they are queued,
+    // not once they are simulated.
+    void   LookupAndFillBatch( const Access *reqs, size_t n );
+
+    // Wait until every routed access has been simulated
+    void   Drain();
+
+    UINT32 NumWorkers() { return numWorkers; }
+    COUNTER EpochCount() { return epochs; }
+
+    // Statistics summed over all shards
+    COUNTER ThreadDemandLookupStats( UINT32 tid );
+    COUNTER ThreadDemandMissStats( UINT32 tid );
+    COUNTER ThreadDemandHitStats( UINT32 tid );
+    COUNTER DirtyEvictionStats();
+
+  private:
+
+    UINT32 GetSetIndex( Addr_t addr ) { return ((addr >> lineShift) & indexMask); }
+    UINT32 GetWorker( Addr_t addr ) { return GetSetIndex( addr ) & (numWorkers - 1); }
+
+    void   Flush( CRC_PARALLEL_WORKER *w );
+    void   WaitIdle();
+    void   MergeGlobalState();
+    void   MergePredictor();
+
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include <cstring>
+#include <cassert>
+#include "crc_set_dueling.h"
+
+// Places the leader of rank k: the splitmix64 finalizer of k
+static inline unsigned long long DuelHash( unsigned long long k )
+{
+    k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    k = (k ^ (k >> 27)) * 0x94d049bb133111ebULL;
+    return k ^ (k >> 31);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor places the leader sets. Rank k goes to thread k % threads  //
+// and policy k / threads % policies, at the set its hash names or the next   //
+// free one. At most half of the sets lead; fewer leaders per policy are      //
+// placed if the cache is too small for the requested number.                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_SET_DUELING::CRC_SET_DUELING( UINT32 _sets, UINT32 _policies, UINT32 _threads, UINT32 _leaders, UINT32 _counterBits )
+{
+    assert( _policies >= 2 && _policies <= CRC_DUEL_MAX_POLICIES );
+    assert( _threads >= 1 && _threads <= CRC_DUEL_MAX_THREADS );
+    assert( _counterBits >= 1 && _counterBits <= CRC_DUEL_MAX_BITS );
+
+    numsets     = _sets;
+    policies    = _policies;
+    threads     = _threads;
+    counterBits = _counterBits;
+    counterMax  = (1 << counterBits) - 1;
+
+    for(leaves=1; leaves<policies; leaves<<=1);
+
+    leaders = _leaders;
+    if( (unsigned long long)leaders * policies * threads > numsets / 2 ) leaders = numsets / 2 / (policies * threads);
+    if( leaders < 1 ) leaders = 1;
+
+    // every thread needs a leader set for every policy
+    assert( policies * threads <= numsets );
+
+    role = new unsigned short[ numsets ];
+    memset( role, 0, numsets * sizeof(unsigned short) );
+
+    for(UINT32 k=0; k<leaders * policies * threads; k++)
+    {
+        UINT32 setIndex = (UINT32)( DuelHash( k ) % numsets );
+
+        while( role[ setIndex ] ) setIndex = (setIndex + 1) % numsets;
+
+        role[ setIndex ] = 1 + (k % threads) * policies + (k / threads) % policies;
+    }
+
+    counters      = new UINT32[ threads * (leaves - 1) ];
+    winner        = new unsigned char[ threads ];
+    followerFills = new COUNTER[ threads * policies ];
+    leaderMisses  = new COUNTER[ threads * policies ];
+    intervalFills = new COUNTER[ threads * policies ];
+
+    for(UINT32 i=0; i<threads * (leaves - 1); i++) counters[i] = (counterMax + 1) / 2;
+    for(UINT32 t=0; t<threads; t++) winner[t] = Tournament( t, 1 );
+
+    memset( followerFills, 0, threads * policies * sizeof(COUNTER) );
+    memset( leaderMisses, 0, threads * policies * sizeof(COUNTER) );
+    memset( intervalFills, 0, threads * policies * sizeof(COUNTER) );
+
+    traceInterval = 0;
+    sinceTrace    = 0;
+    traceRecords  = 0;
+    traceCapacity = 0;
+    traceWinner   = NULL;
+    traceFills    = NULL;
+}
+
+CRC_SET_DUELING::~CRC_SET_DUELING()
+{
+    delete [] role;
+    delete [] counters;
+    delete [] winner;
+    delete [] followerFills;
+    delete [] leaderMisses;
+    delete [] intervalFills;
+    delete [] traceWinner;
+    delete [] traceFills;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// A leader miss of a policy: at every node on the way up, as long as the     //
+// policy wins the child it came from, the counter moves towards the other    //
+// child (up if the miss came from the left)                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_SET_DUELING::Train( UINT32 tid, UINT32 policy )
+{
+    UINT32 *tree = &counters[ tid * (leaves - 1) ];
+
+    for(UINT32 child=leaves + policy; child>1 && Tournament( tid, child ) == policy; child>>=1)
+    {
+        UINT32 &counter = tree[ (child >> 1) - 1 ];
+
+        if( child & 1 )
+        {
+            if( counter > 0 ) counter--;
+        }
+        else if( counter < counterMax )
+        {
+            counter++;
+        }
+    }
+
+    winner[ tid ] = Tournament( tid, 1 );
+}
+
+// The winner of the subtree under node (1: the whole tree)
+UINT32 CRC_SET_DUELING::Tournament( UINT32 tid, UINT32 node )
+{
+    const UINT32 *tree = &counters[ tid * (leaves - 1) ];
+
+    while( node < leaves )
+    {
+        UINT32 right = 2 * node + 1;
+        UINT32 first = right;
+
+        // a right subtree of padding only is never chosen
+        while( first < leaves ) first <<= 1;
+
+        node = (first - leaves < policies && tree[ node - 1 ] > (counterMax + 1) / 2) ? right : 2 * node;
+    }
+
+    return node - leaves;
+}
+
+void CRC_SET_DUELING::SetCounter( UINT32 i, UINT32 value )
+{
+    counters[i] = (value > counterMax) ? counterMax : value;
+    winner[ i / (leaves - 1) ] = Tournament( i / (leaves - 1), 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Per-interval trace; the record arrays double when full                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_SET_DUELING::SetTraceInterval( COUNTER interval )
+{
+    traceInterval = interval;
+    sinceTrace    = 0;
+}
+
+void CRC_SET_DUELING::RecordInterval()
+{
+    if( traceRecords == traceCapacity )
+    {
+        COUNTER        capacity = traceCapacity ? 2 * traceCapacity : 64;
+        unsigned char *winners  = new unsigned char[ capacity * threads ];
+        COUNTER       *fills    = new COUNTER[ capacity * threads * policies ];
+
+        if( traceRecords )
+        {
+            memcpy( winners, traceWinner, traceRecords * threads );
+            memcpy( fills, traceFills, traceRecords * threads * policies * sizeof(COUNTER) );
+        }
+
+        delete [] traceWinner;
+        delete [] traceFills;
+
+        traceWinner   = winners;
+        traceFills    = fills;
+        traceCapacity = capacity;
+    }
+
+    memcpy( &traceWinner[ traceRecords * threads ], winner, threads );
+    memcpy( &traceFills[ traceRecords * threads * policies ], intervalFills, threads * policies * sizeof(COUNTER) );
+    memset( intervalFills, 0, threads * policies * sizeof(COUNTER) );
+
+    traceRecords++;
+    sinceTrace = 0;
+}
+
+size_t CRC_SET_DUELING::Bytes()
+{
+    return numsets * sizeof(unsigned short) + threads * (leaves - 1) * sizeof(UINT32) + threads;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The functions print, per thread, the winner with the leader misses and     //
+// follower fills of every policy, and the trace                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_SET_DUELING::PrintStats( ostream &out, const char *const *names )
+{
+    out<<"\tLeader Sets:     "<<leaders<<" per policy and thread, hashed; "<<counterBits<<"-bit counters"<<endl;
+
+    for(UINT32 t=0; t<threads; t++)
+    {
+        out<<"\tThread "<<t<<":        "<<names[ winner[t] ];
+
+        for(UINT32 p=0; p<policies; p++)
+        {
+            out<<", "<<names[p]<<" "<<leaderMisses[ t * policies + p ]<<" leader misses "
+               <<followerFills[ t * policies + p ]<<" fills";
+        }
+
+        out<<endl;
+    }
+
+    return out;
+}
+
+ostream & CRC_SET_DUELING::PrintTrace( ostream &out, const char *const *names )
+{
+    out<<"\tWinner Trace:    every "<<traceInterval<<" fills; thread: winner (follower fills per policy)"<<endl;
+
+    for(COUNTER k=0; k<traceRecords; k++)
+    {
+        out<<"\t  "<<(k + 1) * traceInterval;
+
+        for(UINT32 t=0; t<threads; t++)
+        {
+            out<<"  "<<t<<": "<<names[ traceWinner[ k * threads + t ] ]<<" (";
+
+            for(UINT32 p=0; p<policies; p++)
+            {
+                out<<(p ? " " : "")<<traceFills[ (k * threads + t) * policies + p ];
+            }
+
+            out<<")";
+        }
+
+        out<<endl;
+    }
+
+    return out;
+}
@@ -0,0 +1,140 @@
+#ifndef CRC_SET_DUELING_H
+#define CRC_SET_DUELING_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Set dueling between N candidate policies (Qureshi et al., ISCA 2007),      //
+// per thread as in TA-DRRIP.                                                 //
+//                                                                            //
+// Every thread owns `leaders` sets per policy; an access by the thread to    //
+// one of its leader sets always uses that set's policy. Accesses by other    //
+// threads there follow their own winners, but every fill in the set, by any  //
+// thread, counts as a miss of the owner's policy (as in TADIP-F): a thread's //
+// policy is judged by the misses it causes the whole cache, so a streaming   //
+// thread that misses either way still learns to stay out of the others'      //
+// way. Leader sets are placed by a hash of their rank rather than at fixed   //
+// strides, so a strided access pattern does not land on the leaders of one   //
+// policy only. All other accesses follow the thread's current winner.        //
+//                                                                            //
+// The winner is decided by a tournament: the policies are the leaves of a    //
+// binary tree (padded to a power of two) and every inner node holds a        //
+// saturating counter of counterBits bits, starting at the middle. The winner //
+// of a subtree is found by descending into the left child unless the         //
+// counter is above the middle. A leader miss of a policy moves the counter   //
+// of each node on its path to the root away from the policy's side, but only //
+// up to where the policy stops winning its side: a node duels the winners of //
+// its two children, not the sums of their misses. With two policies this is  //
+// the single PSEL counter of DIP and DRRIP.                                  //
+//                                                                            //
+// With a trace interval set, every interval fills the winner of each thread  //
+// and the follower fills per policy since the last record are kept, for      //
+// PrintTrace.                                                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+
+#define CRC_DUEL_MAX_POLICIES   16
+#define CRC_DUEL_MAX_THREADS    64
+#define CRC_DUEL_MAX_BITS       16
+
+class CRC_SET_DUELING
+{
+  private:
+
+    UINT32 numsets;
+    UINT32 policies;
+    UINT32 threads;
+    UINT32 leaders;         // per thread and policy
+    UINT32 counterBits;
+    UINT32 counterMax;
+    UINT32 leaves;          // policies rounded up to a power of two
+
+    // per set: 0 for a follower, else 1 + tid * policies + policy
+    unsigned short *role;
+
+    // per thread: inner nodes 1 .. leaves-1 of its tree, and its winner
+    UINT32         *counters;
+    unsigned char  *winner;
+
+    // per thread and policy
+    COUNTER        *followerFills;
+    COUNTER        *leaderMisses;
+
+    // per-interval trace: record k holds the winner of each thread and its
+    // follower fills per policy during the interval
+    COUNTER         traceInterval;
+    COUNTER         sinceTrace;
+    COUNTER         traceRecords;
+    COUNTER         traceCapacity;
+    unsigned char  *traceWinner;
+    COUNTER        *traceFills;
+    COUNTER        *intervalFills;
+
+  public:
+
+    CRC_SET_DUELING( UINT32 _sets, UINT32 _policies, UINT32 _threads, UINT32 _leaders, UINT32 _counterBits );
+    ~CRC_SET_DUELING();
+
+    bool    IsLeader( UINT32 setIndex ) { return role[ setIndex ] != 0; }
+
+    // The policy an access by thread tid to the set is made under
+    UINT32  Policy( UINT32 setIndex, UINT32 tid )
+    {
+        UINT32 r = role[ setIndex ];
+
+        if( r && (r - 1) / policies == tid ) return (r - 1) % policies;
+
+        return winner[ tid ];
+    }
+
+    // A fill by thread tid under policy (as returned by Policy): in a leader
+    // set it trains the owner's tournament; it counts as a follower fill of
+    // tid unless tid owns the set
+    void    Fill( UINT32 setIndex, UINT32 tid, UINT32 policy )
+    {
+        UINT32 r = role[ setIndex ];
+
+        if( r )
+        {
+            leaderMisses[ r - 1 ]++;
+            Train( (r - 1) / policies, (r - 1) % policies );
+        }
+
+        if( !r || (r - 1) / policies != tid )
+        {
+            followerFills[ tid * policies + policy ]++;
+            if( traceInterval ) intervalFills[ tid * policies + policy ]++;
+        }
+
+        if( traceInterval && ++sinceTrace == traceInterval ) RecordInterval();
+    }
+
+    UINT32  Winner( UINT32 tid ) { return winner[ tid ]; }
+    UINT32  NumPolicies() { return policies; }
+    UINT32  LeadersPerPolicy() { return leaders; }
+
+    // Every counter of every thread, so that instances simulating parts of
+    // one cache can be kept in step
+    UINT32  NumCounters() { return threads * (leaves - 1); }
+    UINT32  GetCounter( UINT32 i ) { return counters[i]; }
+    void    SetCounter( UINT32 i, UINT32 value );
+    UINT32  CounterMax() { return counterMax; }
+
+    // Record the winners every interval fills (0: no trace)
+    void    SetTraceInterval( COUNTER interval );
+
+    size_t  Bytes();
+
+    ostream &   PrintStats( ostream &out, const char *const *names );
+    ostream &   PrintTrace( ostream &out, const char *const *names );
+
+  private:
+
+    void    Train( UINT32 tid, UINT32 policy );
+    UINT32  Tournament( UINT32 tid, UINT32 node );
+    void    RecordInterval();
+
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cassert>
+#include "crc_set_sample.h"
+
+// Picks hashed followers: the high half of a Fibonacci hash of the set index
+static inline UINT32 SampleHash( UINT32 setIndex )
+{
+    return (UINT32)( ((unsigned long long)setIndex * 0x9e3779b97f4a7c15ULL) >> 32 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor decides which sets are simulated: all leader sets of the   //
+// policy plus 1 in ratio of the others                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_SET_SAMPLER::CRC_SET_SAMPLER( UINT32 _sets, UINT32 _threads, UINT32 _mode, UINT32 _ratio, CACHE_REPLACEMENT_STATE *repl )
+{
+    assert( _mode == CRC_SAMPLE_STRIDE || _mode == CRC_SAMPLE_HASH );
+    assert( _ratio >= 1 );
+
+    numsets = _sets;
+    threads = _threads;
+    mode    = _mode;
+    ratio   = _ratio;
+
+    sampleOf         = new UINT32[ numsets ];
+    leader           = new bool[ numsets ];
+    simulated        = 0;
+    leaders          = 0;
+    followers        = 0;
+    sampledFollowers = 0;
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+    {
+        bool isLeader = repl->IsLeaderSet( setIndex );
+        bool picked   = (mode == CRC_SAMPLE_STRIDE) ? (setIndex % ratio == 0) : (SampleHash( setIndex ) % ratio == 0);
+
+        sampleOf[ setIndex ] = CRC_SAMPLE_NOT_SIMULATED;
+
+        if( isLeader )
+        {
+            leaders++;
+        }
+        else
+        {
+            followers++;
+            sampledFollowers += picked;
+        }
+
+        if( isLeader || picked )
+        {
+            leader[ simulated ]  = isLeader;
+            sampleOf[ setIndex ] = simulated++;
+        }
+    }
+
+    setLookups      = new COUNTER[ (size_t)simulated * ACCESS_MAX ];
+    setMisses       = new COUNTER[ (size_t)simulated * ACCESS_MAX ];
+    followerLookups = new COUNTER[ threads ];
+    followerMisses  = new COUNTER[ threads ];
+
+    for(size_t i=0; i<(size_t)simulated * ACCESS_MAX; i++)
+    {
+        setLookups[i] = 0;
+        setMisses[i]  = 0;
+    }
+
+    for(UINT32 t=0; t<threads; t++)
+    {
+        followerLookups[t] = 0;
+        followerMisses[t]  = 0;
+    }
+}
+
+CRC_SET_SAMPLER::~CRC_SET_SAMPLER()
+{
+    delete [] sampleOf;
+    delete [] leader;
+    delete [] setLookups;
+    delete [] setMisses;
+    delete [] followerLookups;
+    delete [] followerMisses;
+}
+
+void CRC_SET_SAMPLER::Record( UINT32 setIndex, UINT32 tid, UINT32 accessType, bool hit )
+{
+    UINT32 s = sampleOf[ setIndex ];
+
+    setLookups[ (size_t)s * ACCESS_MAX + accessType ]++;
+    setMisses[ (size_t)s * ACCESS_MAX + accessType ] += !hit;
+
+    if( !leader[s] && accessType <= ACCESS_STORE )
+    {
+        followerLookups[ tid ]++;
+        followerMisses[ tid ] += !hit;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Per-thread demand counts: leader accesses count once, follower accesses    //
+// are scaled up                                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+COUNTER CRC_SET_SAMPLER::ThreadDemandLookups( UINT32 tid, COUNTER simulatedLookups )
+{
+    return simulatedLookups - followerLookups[ tid ] + (COUNTER)( followerLookups[ tid ] * FollowerScale() + 0.5 );
+}
+
+COUNTER CRC_SET_SAMPLER::ThreadDemandMisses( UINT32 tid, COUNTER simulatedMisses )
+{
+    return simulatedMisses - followerMisses[ tid ] + (COUNTER)( followerMisses[ tid ] * FollowerScale() + 0.5 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function estimates the whole-cache total of a per-set value            //
+// x = lookupWeight * lookups + missWeight * misses. Leaders contribute their //
+// exact sum; the follower sample is scaled up, and the variance of that      //
+// scaled sum gives the confidence interval.                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+double CRC_SET_SAMPLER::Estimate( UINT32 accessType, double lookupWeight, double missWeight, double &halfWidth )
+{
+    UINT32 first = (accessType == ACCESS_MAX) ? 0 : accessType;
+    UINT32 last  = (accessType == ACCESS_MAX) ? ACCESS_MAX : accessType + 1;
+
+    double leaderSum = 0, followerSum = 0, followerSq = 0;
+
+    for(UINT32 s=0; s<simulated; s++)
+    {
+        double x = 0;
+
+        for(UINT32 a=first; a<last; a++)
+        {
+            x += lookupWeight * setLookups[ (size_t)s * ACCESS_MAX + a ] + missWeight * setMisses[ (size_t)s * ACCESS_MAX + a ];
+        }
+
+        if( leader[s] )
+        {
+            leaderSum += x;
+        }
+        else
+        {
+            followerSum += x;
+            followerSq  += x * x;
+        }
+    }
+
+    halfWidth = 0;
+
+    if( sampledFollowers > 1 )
+    {
+        double n    = sampledFollowers;
+        double mean = followerSum / n;
+        double var  = (followerSq - n * mean * mean) / (n - 1);
+        double fpc  = 1.0 - n / followers;
+
+        if( var > 0 && fpc > 0 ) halfWidth = 1.96 * followers * sqrt( fpc * var / n );
+    }
+
+    return leaderSum + followerSum * FollowerScale();
+}
+
+double CRC_SET_SAMPLER::EstimateLookups( UINT32 accessType, double &halfWidth )
+{
+    return Estimate( accessType, 1, 0, halfWidth );
+}
+
+double CRC_SET_SAMPLER::EstimateMisses( UINT32 accessType, double &halfWidth )
+{
+    return Estimate( accessType, 0, 1, halfWidth );
+}
+
+double CRC_SET_SAMPLER::EstimateMissRate( UINT32 accessType, double &halfWidth )
+{
+    double unused;
+    double lookups = EstimateLookups( accessType, unused );
+    double misses  = EstimateMisses( accessType, unused );
+
+    halfWidth = 0;
+    if( lookups <= 0 ) return 0;
+
+    double rate = misses / lookups;
+
+    // ratio estimator: the interval of the residual total misses - rate * lookups
+    Estimate( accessType, -rate, 1, halfWidth );
+    halfWidth /= lookups;
+
+    return rate;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the whole-cache estimates per access type             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CRC_SET_SAMPLER::PrintStats( ostream &out, const string *accessNames )
+{
+    out<<"Set Sampling Estimates (95% confidence): "<<endl;
+    out<<endl;
+    out<<"\tSampling:       "<<((mode == CRC_SAMPLE_STRIDE) ? "stride" : "hash")<<" 1/"<<ratio<<endl;
+    out<<"\tSimulated Sets: "<<simulated<<" of "<<numsets<<" ("<<leaders<<" leader, "
+       <<sampledFollowers<<" of "<<followers<<" follower)"<<endl;
+    out<<endl;
+
+    for(UINT32 a=0; a<=ACCESS_MAX; a++)
+    {
+        double lookupHW, missHW, hitHW, rateHW;
+        double lookups = EstimateLookups( a, lookupHW );
+
+        if( lookups <= 0 ) continue;
+
+        double misses = EstimateMisses( a, missHW );
+        double hits   = Estimate( a, 1, -1, hitHW );
+        double rate   = EstimateMissRate( a, rateHW );
+
+        const string name = (a == ACCESS_MAX) ? string( "TOTAL    " ) : accessNames[a];
+
+        out<<"\t"<<name<<" Accesses:   "<<(COUNTER)( lookups + 0.5 )<<" +- "<<(COUNTER)( lookupHW + 0.5 )<<endl;
+        out<<"\t"<<name<<" Misses:     "<<(COUNTER)( misses + 0.5 )<<" +- "<<(COUNTER)( missHW + 0.5 )<<endl;
+        out<<"\t"<<name<<" Hits:       "<<(COUNTER)( hits + 0.5 )<<" +- "<<(COUNTER)( hitHW + 0.5 )<<endl;
+        out<<"\t"<<name<<" Miss Rate:  "<<rate * 100.0<<" +- "<<rateHW * 100.0<<endl;
+        out<<endl;
+    }
+
+    return out;
+}
@@ -0,0 +1,97 @@
+#ifndef CRC_SET_SAMPLE_H
+#define CRC_SET_SAMPLE_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Set sampling for CRC_CACHE.                                                //
+//                                                                            //
+// Only a subset of the sets is simulated; accesses to the other sets are     //
+// dropped before any lookup work. The simulated sets form two strata:        //
+//                                                                            //
+//   leaders    every set the replacement policy uses for set dueling         //
+//              (CACHE_REPLACEMENT_STATE::IsLeaderSet). They are always       //
+//              simulated so the policy selector trains as in a full run,     //
+//              and they count exactly once in the estimates.                 //
+//                                                                            //
+//   followers  1 in k of the remaining sets, picked by stride (set % k == 0) //
+//              or by a hash of the set index. Each stands for N_F / n_F      //
+//              follower sets.                                                //
+//                                                                            //
+// Statistics are extrapolated per stratum. The 95% confidence intervals      //
+// come from the spread of the per-set counts among the sampled followers     //
+// (with the finite population correction); leaders add no variance.          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "replacement_state.h"
+
+typedef enum
+{
+    CRC_SAMPLE_NONE   = 0,
+    CRC_SAMPLE_STRIDE = 1,
+    CRC_SAMPLE_HASH   = 2
+} SetSamplingMode;
+
+#define CRC_SAMPLE_NOT_SIMULATED (~0U)
+
+class CRC_SET_SAMPLER
+{
+  private:
+
+    UINT32 numsets;
+    UINT32 threads;
+    UINT32 mode;
+    UINT32 ratio;           // 1 in ratio followers simulated
+
+    UINT32 *sampleOf;       // set -> index among simulated sets, or CRC_SAMPLE_NOT_SIMULATED
+    bool   *leader;         // per simulated set
+    UINT32  simulated;
+    UINT32  leaders;
+    UINT32  followers;      // follower sets in the cache
+    UINT32  sampledFollowers;
+
+    // per simulated set and access type
+    COUNTER *setLookups;
+    COUNTER *setMisses;
+
+    // per thread, demand accesses to sampled follower sets
+    COUNTER *followerLookups;
+    COUNTER *followerMisses;
+
+  public:
+
+    CRC_SET_SAMPLER( UINT32 _sets, UINT32 _threads, UINT32 _mode, UINT32 _ratio, CACHE_REPLACEMENT_STATE *repl );
+    ~CRC_SET_SAMPLER();
+
+    bool    Simulated( UINT32 setIndex ) { return sampleOf[ setIndex ] != CRC_SAMPLE_NOT_SIMULATED; }
+
+    void    Record( UINT32 setIndex, UINT32 tid, UINT32 accessType, bool hit );
+
+    // Sets standing behind each sampled follower set
+    double  FollowerScale() { return sampledFollowers ? (double)followers / sampledFollowers : 0; }
+
+    UINT32  SimulatedSets() { return simulated; }
+    UINT32  LeaderSets()    { return leaders; }
+
+    // Extrapolate a per-thread demand count of the simulated sets
+    COUNTER ThreadDemandLookups( UINT32 tid, COUNTER simulatedLookups );
+    COUNTER ThreadDemandMisses( UINT32 tid, COUNTER simulatedMisses );
+
+    // Whole-cache estimates with the half width of their 95% confidence
+    // interval. accessType ACCESS_MAX means all access types.
+    double  EstimateLookups( UINT32 accessType, double &halfWidth );
+    double  EstimateMisses( UINT32 accessType, double &halfWidth );
+    double  EstimateMissRate( UINT32 accessType, double &halfWidth );
+
+    ostream &   PrintStats( ostream &out, const string *accessNames );
+
+  private:
+
+    // weights: hits are per-set lookups minus misses
+    double  Estimate( UINT32 accessType, double lookupWeight, double missWeight, double &halfWidth );
+
+};
+
+#endif
@@ -0,0 +1,317 @@
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include "crc_shards.h"
+#include "crc_tag_store.h"
+
+#define CRC_SHARDS_TWO_64     18446744073709551616.0
+
+// Fewest sets the set-associative curve is estimated from (on average: the
+// sets are picked by hash)
+#define CRC_SHARDS_MIN_SETS   256
+
+static unsigned long long RateToThreshold( double rate )
+{
+    return (rate >= 1.0) ? ~0ULL : (unsigned long long)( rate * CRC_SHARDS_TWO_64 );
+}
+
+// Student t quantile with df degrees of freedom of the interval whose normal
+// quantile is z (Cornish-Fisher expansion; for 95%, within 1% of the exact
+// value from df = 3 up, 0.02% from df = 10)
+static double StudentT( double z, double df )
+{
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    double z7 = z5 * z * z;
+
+    return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df)
+             + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * df * df * df);
+}
+
+// Power of two bucket of a (scaled) stack distance
+static inline UINT32 DistanceBucket( double dist )
+{
+    unsigned long long d = (unsigned long long)dist;
+
+    return d ? 64 - __builtin_clzll( d ) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor picks the sampled sets up front; sampled lines are picked  //
+// as they show up                                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_SHARDS::CRC_SHARDS( UINT32 _sets, UINT32 _linesize, UINT32 _maxWays, double _rate, size_t _maxLines )
+{
+    numsets    = _sets;
+    linesize   = _linesize;
+    maxWays    = _maxWays;
+    maxLines   = _maxLines;
+
+    lineShift  = CRC_FloorLog2( linesize );
+    indexMask  = (1 << CRC_FloorLog2( numsets )) - 1;
+
+    rate       = _rate;
+    threshold  = RateToThreshold( rate );
+
+    heap       = maxLines ? new Addr_t[ maxLines + 1 ] : NULL;
+    heapSize   = 0;
+
+    for(UINT32 b=0; b<CRC_SHARDS_BUCKETS; b++) faHist[b] = 0;
+    faWeight   = 0;
+    faSampled  = 0;
+
+    // sample sets at the initial rate, in fixed size mode no more than
+    // maxLines lines of stacks hold, but never from fewer than
+    // CRC_SHARDS_MIN_SETS sets
+    double setRate = rate;
+    if( maxLines && (double)maxLines / ((double)numsets * maxWays) < setRate ) 
+    {
+        setRate = (double)maxLines / ((double)numsets * maxWays);
+    }
+    if( setRate * numsets < CRC_SHARDS_MIN_SETS ) setRate = (double)CRC_SHARDS_MIN_SETS / numsets;
+    setThreshold = RateToThreshold( setRate );
+
+    sampleOf    = new UINT32[ numsets ];
+    sampledSets = 0;
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+    {
+        sampleOf[ setIndex ] = (CRC_HashLine( setIndex ) < setThreshold) ? sampledSets++ : ~0U;
+    }
+
+    size_t stackSize = (size_t)sampledSets * maxWays;
+
+    setStack    = (Addr_t *) CRC_AlignedAlloc( stackSize * sizeof(Addr_t) );
+    setHist     = new COUNTER[ stackSize ];
+    setAccesses = new COUNTER[ sampledSets ];
+    match       = CRC_TagMatchFunction( CRC_TagMatchBest() );
+
+    // ensure that we were able to create the sampled sets
+    assert(setStack && setHist && setAccesses);
+
+    for(size_t i=0; i<stackSize; i++)
+    {
+        setStack[i] = CRC_INVALID_TAG;
+        setHist[i]  = 0;
+    }
+    for(UINT32 s=0; s<sampledSets; s++) setAccesses[s] = 0;
+
+    accesses   = 0;
+    writebacks = 0;
+}
+
+CRC_SHARDS::~CRC_SHARDS()
+{
+    delete [] heap;
+    delete [] sampleOf;
+    CRC_AlignedFree( setStack );
+    delete [] setHist;
+    delete [] setAccesses;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function drops every access that is in neither sample before doing    //
+// any other work                                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_SHARDS::Reference( const Access &req )
+{
+    if( req.accessType == ACCESS_WRITEBACK )
+    {
+        writebacks++;
+        return;
+    }
+
+    accesses++;
+
+    Addr_t line     = req.paddr >> lineShift;
+    UINT32 sample   = sampleOf[ line & indexMask ];
+    bool   lineKept = CRC_HashLine( line ) < threshold;
+
+    if( sample == ~0U && !lineKept ) return;
+
+    // set-associative: exact stack of a sampled set
+    if( sample != ~0U )
+    {
+        Addr_t *stack   = setStack + (size_t)sample * maxWays;
+        INT32   setDist = match( stack, maxWays, line );
+
+        if( setDist != -1 ) setHist[ (size_t)sample * maxWays + setDist ]++;
+        setAccesses[ sample ]++;
+
+        UINT32 depth = (setDist != -1) ? setDist : maxWays - 1;
+
+        memmove( stack + 1, stack, depth * sizeof(Addr_t) );
+        stack[0] = line;
+    }
+
+    if( !lineKept ) return;
+
+    // fully associative: distance among sampled lines, scaled by 1/R
+    double   weight = 1.0 / rate;
+    COUNTER *slot   = lastUse.Find( line );
+
+    faSampled++;
+    faWeight += weight;
+
+    if( slot )
+    {
+        faHist[ DistanceBucket( reuse.CountAfter( *slot ) * weight ) ] += weight;
+
+        reuse.Release( *slot );
+        *slot = reuse.Append( line, lastUse );
+    }
+    else
+    {
+        lastUse.Set( line, 0 );
+        *lastUse.Find( line ) = reuse.Append( line, lastUse );
+
+        if( maxLines )
+        {
+            HeapPush( line );
+            if( lastUse.Size() > maxLines ) Shrink();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Fixed size: drop the sampled line with the largest hash and lower the      //
+// threshold (and so the rate) to its hash                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_SHARDS::Shrink()
+{
+    Addr_t line = HeapPop();
+
+    threshold = CRC_HashLine( line );
+    rate      = threshold / CRC_SHARDS_TWO_64;
+
+    reuse.Release( *lastUse.Find( line ) );
+    lastUse.Erase( line );
+}
+
+void CRC_SHARDS::HeapPush( Addr_t line )
+{
+    unsigned long long h = CRC_HashLine( line );
+    size_t i = heapSize++;
+
+    while( i > 0 && CRC_HashLine( heap[ (i - 1) / 2 ] ) < h )
+    {
+        heap[i] = heap[ (i - 1) / 2 ];
+        i = (i - 1) / 2;
+    }
+
+    heap[i] = line;
+}
+
+Addr_t CRC_SHARDS::HeapPop()
+{
+    Addr_t top  = heap[0];
+    Addr_t last = heap[ --heapSize ];
+    unsigned long long h = CRC_HashLine( last );
+    size_t i = 0;
+
+    while( true )
+    {
+        size_t child = 2 * i + 1;
+
+        if( child >= heapSize ) break;
+        if( child + 1 < heapSize && CRC_HashLine( heap[ child + 1 ] ) > CRC_HashLine( heap[ child ] ) ) child++;
+        if( CRC_HashLine( heap[ child ] ) <= h ) break;
+
+        heap[i] = heap[ child ];
+        i = child;
+    }
+
+    heap[i] = last;
+
+    return top;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Curve estimates                                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+double CRC_SHARDS::FullyAssocMissRatio( UINT32 log2Lines )
+{
+    double hits = 0;
+
+    for(UINT32 b=0; b<=log2Lines && b<CRC_SHARDS_BUCKETS; b++) hits += faHist[b];
+
+    return (faWeight > 0) ? 1.0 - hits / faWeight : 0;
+}
+
+double CRC_SHARDS::SetAssocMissRatio( UINT32 ways, double &halfWidth, double z )
+{
+    double hits = 0, acc = 0;
+
+    // ratio estimator over the sampled sets
+    for(UINT32 s=0; s<sampledSets; s++)
+    {
+        for(UINT32 d=0; d<ways && d<maxWays; d++) hits += setHist[ (size_t)s * maxWays + d ];
+        acc += setAccesses[s];
+    }
+
+    halfWidth = 0;
+    if( acc == 0 ) return 0;
+
+    double hitRatio = hits / acc;
+
+    if( sampledSets > 1 )
+    {
+        double sq = 0;
+
+        for(UINT32 s=0; s<sampledSets; s++)
+        {
+            double h = 0;
+            for(UINT32 d=0; d<ways && d<maxWays; d++) h += setHist[ (size_t)s * maxWays + d ];
+
+            double e = h - hitRatio * setAccesses[s];
+            sq += e * e;
+        }
+
+        double meanAcc = acc / sampledSets;
+        double fpc     = 1.0 - (double)sampledSets / numsets;
+        double var     = fpc * sq / (sampledSets - 1) / (sampledSets * meanAcc * meanAcc);
+
+        // the per-set spread is itself estimated from the sample
+        halfWidth = StudentT( z, sampledSets - 1 ) * sqrt( var );
+    }
+
+    return 1.0 - hitRatio;
+}
+
+void CRC_SHARDS::WriteCurve( FILE *out, UINT32 maxLog2Lines )
+{
+    fprintf( out, "# SHARDS sampled LRU miss ratio curves: line %u B, %llu accesses, %llu writebacks skipped\n",
+             linesize, accesses, writebacks );
+    fprintf( out, "# %s, final rate %g, %llu sampled accesses, %llu tracked lines\n",
+             maxLines ? "fixed size" : "fixed rate", rate, faSampled, (COUNTER)lastUse.Size() );
+
+    fprintf( out, "# set-associative, %u sets (%u sampled), 95%% confidence half width\n", numsets, sampledSets );
+    fprintf( out, "# %6s %12s %10s %10s\n", "ways", "size_KB", "miss_ratio", "ci95" );
+
+    for(UINT32 ways=1; ways<=maxWays; ways++)
+    {
+        double halfWidth;
+        double ratio = SetAssocMissRatio( ways, halfWidth );
+
+        fprintf( out, "  %6u %12g %10.6f %10.6f\n", ways, (double)numsets * ways * linesize / 1024, ratio, halfWidth );
+    }
+
+    fprintf( out, "# fully associative, no error bound (crc_mrc -exact measures it)\n" );
+    fprintf( out, "# %6s %12s %10s\n", "lines", "size_KB", "miss_ratio" );
+
+    for(UINT32 k=0; k<=maxLog2Lines; k++)
+    {
+        COUNTER lines = 1ULL << k;
+
+        fprintf( out, "  %6llu %12g %10.6f\n", lines, (double)lines * linesize / 1024, FullyAssocMissRatio( k ) );
+    }
+}
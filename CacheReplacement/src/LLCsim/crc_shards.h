@@ -0,0 +1,128 @@
+#ifndef CRC_SHARDS_H
+#define CRC_SHARDS_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Spatially sampled LRU miss ratio curves (SHARDS, Waldspurger et al.,       //
+// FAST'15).                                                                  //
+//                                                                            //
+// A line is sampled when the hash of its address falls below a threshold,    //
+// i.e. at rate R = threshold / 2^64. Every access to a sampled line is       //
+// tracked exactly like in CRC_STACK_DISTANCE, but among sampled lines only,  //
+// so its fully associative stack distance d stands for d / R lines of the    //
+// full trace, and the access itself stands for 1 / R accesses. Miss ratios   //
+// are taken over the sampled accesses alone. (The SHARDS_adj correction,     //
+// which credits the gap between expected and actual sampled accesses to      //
+// distance 0, shifted whole curves when a few hot lines were missed by the   //
+// sample, so it is not applied.)                                             //
+//                                                                            //
+// Fixed rate:  R never changes; the tracked lines grow with the footprint.   //
+//                                                                            //
+// Fixed size:  at most maxLines sampled lines are tracked. When one more     //
+//              would be added, the line with the largest hash is dropped     //
+//              and the threshold lowered to that hash, so R adapts to the    //
+//              footprint and memory stays constant.                          //
+//                                                                            //
+// The set-associative curve samples sets instead (hash of the set index      //
+// below the initial threshold, and in fixed size mode below the rate at      //
+// which the stacks of the sampled sets hold maxLines lines, so memory stays  //
+// bounded there too), some 256 sets at the least: a sampled set is           //
+// simulated exactly, so the per-set hit counts of the sample also give a     //
+// confidence interval for the whole-cache estimate, from the t distribution  //
+// since the spread of the sets is itself estimated. Only this curve has an   //
+// error bound; the error of the fully associative one is only known against  //
+// the exact curve (crc_mrc -exact).                                          //
+//                                                                            //
+// Fully associative distances are kept in power of two buckets, which is     //
+// all WriteCurve prints, so the histogram is constant size too.              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_tag_match.h"
+#include "crc_stack_dist.h"
+
+// Bucket b holds distances in [2^(b-1), 2^b), bucket 0 distance 0
+#define CRC_SHARDS_BUCKETS 66
+
+// Normal quantiles of the two-sided 95% and 99% intervals
+#define CRC_SHARDS_Z95     1.959964
+#define CRC_SHARDS_Z99     2.575829
+
+class CRC_SHARDS
+{
+  private:
+
+    UINT32 numsets;
+    UINT32 linesize;
+    UINT32 maxWays;
+    size_t maxLines;        // 0: fixed rate
+
+    // Lookup Parameters
+    UINT32 lineShift;
+    UINT32 indexMask;
+
+    // line sampling (fully associative curve)
+    unsigned long long threshold;
+    double             rate;
+
+    CRC_LINE_MAP       lastUse;     // sampled line -> slot of its last access
+    CRC_REUSE_COUNTER  reuse;
+
+    // fixed size: max-heap of the sampled lines by hash
+    Addr_t  *heap;
+    size_t   heapSize;
+
+    double   faHist[ CRC_SHARDS_BUCKETS ];   // weighted accesses per bucket
+    double   faWeight;                       // weighted sampled accesses
+    COUNTER  faSampled;
+
+    // set sampling (set-associative curve)
+    unsigned long long setThreshold;
+    UINT32            *sampleOf;    // set -> index among sampled sets, or ~0
+    UINT32             sampledSets;
+    Addr_t            *setStack;    // per sampled set: top maxWays lines
+    COUNTER           *setHist;     // per sampled set: hits per distance
+    COUNTER           *setAccesses; // per sampled set: accesses
+    CRC_TAG_MATCH_FN   match;
+
+    COUNTER  accesses;
+    COUNTER  writebacks;
+
+  public:
+
+    // rate: initial sampling rate; maxLines: 0 for fixed rate, else fixed size
+    CRC_SHARDS( UINT32 _sets, UINT32 _linesize, UINT32 _maxWays, double _rate, size_t _maxLines );
+    ~CRC_SHARDS();
+
+    void    Reference( const Access &req );
+
+    COUNTER Accesses()      { return accesses; }
+    COUNTER Writebacks()    { return writebacks; }
+    COUNTER SampledAccesses() { return faSampled; }
+    size_t  TrackedLines()  { return lastUse.Size(); }
+    UINT32  SampledSets()   { return sampledSets; }
+    double  Rate()          { return rate; }
+
+    // Estimated LRU miss ratio of a fully associative cache of 2^log2Lines lines
+    double  FullyAssocMissRatio( UINT32 log2Lines );
+
+    // Estimated LRU miss ratio of a numsets x ways cache, with the half
+    // width of its confidence interval: 95% for z = CRC_SHARDS_Z95, 99%
+    // for CRC_SHARDS_Z99
+    double  SetAssocMissRatio( UINT32 ways, double &halfWidth, double z=CRC_SHARDS_Z95 );
+
+    // Write both curves as text, in the layout of CRC_STACK_DISTANCE
+    void    WriteCurve( FILE *out, UINT32 maxLog2Lines );
+
+  private:
+
+    void    HeapPush( Addr_t line );
+    Addr_t  HeapPop();
+    void    Shrink();
+
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef CRC_SPSC_H
+#define CRC_SPSC_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Bounded single-producer/single-consumer ring buffer.                       //
+//                                                                            //
+// One thread pushes and one thread pops; neither ever takes a lock. The      //
+// producer publishes new records with a release store of the tail index,     //
+// the consumer hands slots back with a release store of the head index.      //
+// Records move in runs (PushMany/PopMany) so the index cache lines bounce    //
+// between the two cores once per run rather than once per record. Each side  //
+// also keeps a private copy of the other side's index and only re-reads the  //
+// shared one when the copy says the ring is full (or empty).                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cassert>
+#include "crc_tag_store.h"
+
+template <class T>
+class CRC_SPSC_RING
+{
+  private:
+
+    T      *slots;
+    size_t  mask;     // capacity-1, capacity is a power of two
+
+    // indices only ever grow; a slot is index & mask. Producer and consumer
+    // fields live on separate host cache lines.
+    char    pad0[ CRC_HOST_LINE_SIZE ];
+    size_t  tail;          // written by the producer
+    size_t  cachedHead;    // producer's copy of head
+    char    pad1[ CRC_HOST_LINE_SIZE ];
+    size_t  head;          // written by the consumer
+    size_t  cachedTail;    // consumer's copy of tail
+    char    pad2[ CRC_HOST_LINE_SIZE ];
+
+  public:
+
+    CRC_SPSC_RING( size_t capacity )
+    {
+        // the capacity must be a power of two
+        assert( capacity && !(capacity & (capacity - 1)) );
+
+        slots      = (T *) CRC_AlignedAlloc( capacity * sizeof(T) );
+        mask       = capacity - 1;
+        tail       = 0;
+        cachedHead = 0;
+        head       = 0;
+        cachedTail = 0;
+
+        assert( slots );
+    }
+
+    ~CRC_SPSC_RING()
+    {
+        CRC_AlignedFree( slots );
+    }
+
+    // Producer: append up to n records, returns how many fit
+    size_t PushMany( const T *src, size_t n )
+    {
+        size_t capacity = mask + 1;
+
+        if( tail + n - cachedHead > capacity )
+        {
+            cachedHead = __atomic_load_n( &head, __ATOMIC_ACQUIRE );
+        }
+
+        size_t room = capacity - (tail - cachedHead);
+        size_t count = (n < room) ? n : room;
+
+        for(size_t i=0; i<count; i++)
+        {
+            slots[ (tail + i) & mask ] = src[i];
+        }
+
+        __atomic_store_n( &tail, tail + count, __ATOMIC_RELEASE );
+
+        return count;
+    }
+
+    // Consumer: remove up to max records into dst, returns how many
+    size_t PopMany( T *dst, size_t max )
+    {
+        if( cachedTail == head )
+        {
+            cachedTail = __atomic_load_n( &tail, __ATOMIC_ACQUIRE );
+        }
+
+        size_t avail = cachedTail - head;
+        size_t count = (max < avail) ? max : avail;
+
+        for(size_t i=0; i<count; i++)
+        {
+            dst[i] = slots[ (head + i) & mask ];
+        }
+
+        __atomic_store_n( &head, head + count, __ATOMIC_RELEASE );
+
+        return count;
+    }
+
+};
+
+#endif
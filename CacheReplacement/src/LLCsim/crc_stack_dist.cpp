@@ -0,0 +1,369 @@
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include "crc_stack_dist.h"
+#include "crc_tag_store.h"
+
+#define CRC_LINE_MAP_EMPTY    (~0ULL)
+#define CRC_LINE_MAP_INITIAL  (1 << 16)
+#define CRC_REUSE_INITIAL     (1 << 16)
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// CRC_LINE_MAP: linear probing, kept at most half full. Erase shifts the    //
+// following entries of the run back so no tombstones are needed.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_LINE_MAP::CRC_LINE_MAP()
+{
+    mask   = CRC_LINE_MAP_INITIAL - 1;
+    count  = 0;
+    keys   = new Addr_t[ mask + 1 ];
+    values = new COUNTER[ mask + 1 ];
+
+    for(size_t i=0; i<=mask; i++) keys[i] = CRC_LINE_MAP_EMPTY;
+}
+
+CRC_LINE_MAP::~CRC_LINE_MAP()
+{
+    delete [] keys;
+    delete [] values;
+}
+
+size_t CRC_LINE_MAP::Slot( Addr_t line )
+{
+    size_t i = CRC_HashLine( line ) & mask;
+
+    while( keys[i] != CRC_LINE_MAP_EMPTY && keys[i] != line )
+    {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+COUNTER *CRC_LINE_MAP::Find( Addr_t line )
+{
+    size_t i = Slot( line );
+
+    return (keys[i] == line) ? &values[i] : NULL;
+}
+
+void CRC_LINE_MAP::Set( Addr_t line, COUNTER value )
+{
+    size_t i = Slot( line );
+
+    if( keys[i] != line )
+    {
+        if( 2 * (count + 1) > mask + 1 )
+        {
+            Grow();
+            i = Slot( line );
+        }
+
+        keys[i] = line;
+        count++;
+    }
+
+    values[i] = value;
+}
+
+void CRC_LINE_MAP::Erase( Addr_t line )
+{
+    size_t i = Slot( line );
+
+    if( keys[i] != line ) return;
+
+    keys[i] = CRC_LINE_MAP_EMPTY;
+    count--;
+
+    // move back any entry of the run that can no longer be reached
+    for(size_t j=(i + 1) & mask; keys[j] != CRC_LINE_MAP_EMPTY; j=(j + 1) & mask)
+    {
+        size_t home = CRC_HashLine( keys[j] ) & mask;
+
+        // can j's entry live at i? only if i lies cyclically in [home, j)
+        if( ((j - home) & mask) >= ((j - i) & mask) )
+        {
+            keys[i]   = keys[j];
+            values[i] = values[j];
+            keys[j]   = CRC_LINE_MAP_EMPTY;
+            i = j;
+        }
+    }
+}
+
+void CRC_LINE_MAP::Grow()
+{
+    Addr_t  *oldKeys   = keys;
+    COUNTER *oldValues = values;
+    size_t   oldSize   = mask + 1;
+
+    mask   = 2 * oldSize - 1;
+    keys   = new Addr_t[ mask + 1 ];
+    values = new COUNTER[ mask + 1 ];
+
+    for(size_t i=0; i<=mask; i++) keys[i] = CRC_LINE_MAP_EMPTY;
+
+    for(size_t i=0; i<oldSize; i++)
+    {
+        if( oldKeys[i] == CRC_LINE_MAP_EMPTY ) continue;
+
+        size_t j  = Slot( oldKeys[i] );
+        keys[j]   = oldKeys[i];
+        values[j] = oldValues[i];
+    }
+
+    delete [] oldKeys;
+    delete [] oldValues;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// CRC_REUSE_COUNTER                                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_REUSE_COUNTER::CRC_REUSE_COUNTER()
+{
+    capacity = CRC_REUSE_INITIAL;
+    next     = 0;
+    marked   = 0;
+    tree     = (UINT32 *) calloc( capacity + 1, sizeof(UINT32) );
+    slotLine = (Addr_t *) malloc( capacity * sizeof(Addr_t) );
+
+    // ensure that we were able to create the counter
+    assert(tree && slotLine);
+}
+
+CRC_REUSE_COUNTER::~CRC_REUSE_COUNTER()
+{
+    free( tree );
+    free( slotLine );
+}
+
+void CRC_REUSE_COUNTER::Add( size_t slot, INT32 delta )
+{
+    for(size_t i=slot+1; i<=capacity; i+=i & -i) tree[i] += delta;
+}
+
+size_t CRC_REUSE_COUNTER::CountAfter( size_t slot )
+{
+    size_t upTo = 0;
+
+    // marked slots in [0, slot]
+    for(size_t i=slot+1; i>0; i-=i & -i) upTo += tree[i];
+
+    return marked - upTo;
+}
+
+void CRC_REUSE_COUNTER::Release( size_t slot )
+{
+    Add( slot, -1 );
+    slotLine[ slot ] = CRC_LINE_MAP_EMPTY;
+    marked--;
+}
+
+size_t CRC_REUSE_COUNTER::Append( Addr_t line, CRC_LINE_MAP &lineSlots )
+{
+    if( next == capacity ) Compact( lineSlots );
+
+    size_t slot = next++;
+
+    Add( slot, 1 );
+    slotLine[ slot ] = line;
+    marked++;
+
+    return slot;
+}
+
+void CRC_REUSE_COUNTER::Compact( CRC_LINE_MAP &lineSlots )
+{
+    size_t live = 0;
+
+    for(size_t slot=0; slot<next; slot++)
+    {
+        if( slotLine[ slot ] == CRC_LINE_MAP_EMPTY ) continue;
+
+        slotLine[ live ] = slotLine[ slot ];
+        *lineSlots.Find( slotLine[ live ] ) = live;
+        live++;
+    }
+
+    if( 2 * live > capacity )
+    {
+        capacity *= 2;
+        tree      = (UINT32 *) realloc( tree, (capacity + 1) * sizeof(UINT32) );
+        slotLine  = (Addr_t *) realloc( slotLine, capacity * sizeof(Addr_t) );
+        assert(tree && slotLine);
+    }
+
+    next = live;
+
+    // rebuild the tree in linear time: leaves first, then push each node
+    // into its parent
+    for(size_t i=1; i<=capacity; i++) tree[i] = (i <= live);
+
+    for(size_t i=1; i<=capacity; i++)
+    {
+        size_t parent = i + (i & -i);
+        if( parent <= capacity ) tree[ parent ] += tree[i];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// CRC_STACK_DISTANCE                                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_STACK_DISTANCE::CRC_STACK_DISTANCE( UINT32 _sets, UINT32 _linesize, UINT32 _maxWays )
+{
+    numsets    = _sets;
+    linesize   = _linesize;
+    maxWays    = _maxWays;
+
+    lineShift  = CRC_FloorLog2( linesize );
+    indexMask  = (1 << CRC_FloorLog2( numsets )) - 1;
+
+    setStack   = (Addr_t *) CRC_AlignedAlloc( (size_t)numsets * maxWays * sizeof(Addr_t) );
+    setHist    = new COUNTER[ maxWays ];
+    faHistSize = 1024;
+    faHist     = (COUNTER *) calloc( faHistSize, sizeof(COUNTER) );
+    match      = CRC_TagMatchFunction( CRC_TagMatchBest() );
+
+    // ensure that we were able to create the stacks and histograms
+    assert(setStack && setHist && faHist);
+
+    for(size_t i=0; i<(size_t)numsets * maxWays; i++) setStack[i] = CRC_INVALID_TAG;
+    for(UINT32 d=0; d<maxWays; d++) setHist[d] = 0;
+
+    accesses   = 0;
+    writebacks = 0;
+}
+
+CRC_STACK_DISTANCE::~CRC_STACK_DISTANCE()
+{
+    CRC_AlignedFree( setStack );
+    delete [] setHist;
+    free( faHist );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function records the set-associative and fully associative stack       //
+// distance of one access and moves its line to the top of both stacks        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_STACK_DISTANCE::Reference( const Access &req )
+{
+    if( req.accessType == ACCESS_WRITEBACK )
+    {
+        writebacks++;
+        return;
+    }
+
+    accesses++;
+
+    Addr_t  line     = req.paddr >> lineShift;
+    UINT32  setIndex = line & indexMask;
+    Addr_t *stack    = setStack + (size_t)setIndex * maxWays;
+
+    // set-associative: find the line in the set's stack and move it to the
+    // top (pushing out the bottom entry if it was not there)
+    INT32 setDist = match( stack, maxWays, line );
+
+    if( setDist != -1 ) setHist[ setDist ]++;
+
+    UINT32 depth = (setDist != -1) ? setDist : maxWays - 1;
+
+    memmove( stack + 1, stack, depth * sizeof(Addr_t) );
+    stack[0] = line;
+
+    // fully associative
+    COUNTER *slot = lastUse.Find( line );
+
+    if( slot )
+    {
+        size_t faDist = reuse.CountAfter( *slot );
+
+        if( faDist >= faHistSize )
+        {
+            size_t oldSize = faHistSize;
+
+            while( faDist >= faHistSize ) faHistSize *= 2;
+
+            faHist = (COUNTER *) realloc( faHist, faHistSize * sizeof(COUNTER) );
+            assert(faHist);
+
+            for(size_t d=oldSize; d<faHistSize; d++) faHist[d] = 0;
+        }
+        faHist[ faDist ]++;
+
+        reuse.Release( *slot );
+    }
+    else
+    {
+        lastUse.Set( line, 0 );
+    }
+
+    size_t newSlot = reuse.Append( line, lastUse );
+    *lastUse.Find( line ) = newSlot;
+}
+
+COUNTER CRC_STACK_DISTANCE::SetAssocHits( UINT32 ways )
+{
+    COUNTER hits = 0;
+
+    for(UINT32 d=0; d<ways && d<maxWays; d++) hits += setHist[d];
+
+    return hits;
+}
+
+COUNTER CRC_STACK_DISTANCE::FullyAssocHits( COUNTER lines )
+{
+    COUNTER hits = 0;
+
+    for(size_t d=0; d<lines && d<faHistSize; d++) hits += faHist[d];
+
+    return hits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function writes the set-associative curve for 1..maxWays ways and the  //
+// fully associative curve for power of two capacities up to the footprint    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CRC_STACK_DISTANCE::WriteCurve( FILE *out )
+{
+    COUNTER hits = 0;
+
+    fprintf( out, "# LRU miss ratio curves: line %u B, %llu accesses, %llu writebacks skipped, %llu distinct lines\n",
+             linesize, accesses, writebacks, (COUNTER)lastUse.Size() );
+
+    fprintf( out, "# set-associative, %u sets\n", numsets );
+    fprintf( out, "# %6s %12s %14s %14s %10s\n", "ways", "size_KB", "hits", "misses", "miss_ratio" );
+
+    for(UINT32 ways=1; ways<=maxWays; ways++)
+    {
+        hits += setHist[ ways - 1 ];
+
+        fprintf( out, "  %6u %12g %14llu %14llu %10.6f\n", ways, (double)numsets * ways * linesize / 1024,
+                 hits, accesses - hits, accesses ? (double)(accesses - hits) / accesses : 0.0 );
+    }
+
+    fprintf( out, "# fully associative\n" );
+    fprintf( out, "# %6s %12s %14s %14s %10s\n", "lines", "size_KB", "hits", "misses", "miss_ratio" );
+
+    COUNTER footprint = lastUse.Size();
+
+    hits = 0;
+    for(COUNTER lines=1, d=0; ; lines*=2)
+    {
+        for(; d<lines && d<faHistSize; d++) hits += faHist[d];
+
+        fprintf( out, "  %6llu %12g %14llu %14llu %10.6f\n", lines, (double)lines * linesize / 1024,
+                 hits, accesses - hits, accesses ? (double)(accesses - hits) / accesses : 0.0 );
+
+        if( lines >= footprint ) break;
+    }
+}
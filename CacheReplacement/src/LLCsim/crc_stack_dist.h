@@ -0,0 +1,187 @@
+#ifndef CRC_STACK_DIST_H
+#define CRC_STACK_DIST_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Single-pass LRU miss ratio curves (Mattson stack distances).               //
+//                                                                            //
+// An LRU cache of capacity C hits on an access exactly when fewer than C     //
+// distinct lines were touched since the previous access to the same line     //
+// (its stack distance). So one pass that records the stack distance of      //
+// every access yields the hit count of every capacity at once.               //
+//                                                                            //
+// Two distances are tracked per access:                                      //
+//                                                                            //
+//   set-associative   among lines of the same set, for a fixed set count,    //
+//                     giving hits for every associativity 1..maxWays. Only   //
+//                     the top maxWays entries of each set's stack matter,    //
+//                     so they are kept as a small array searched with the    //
+//                     tag match kernels of the tag store.                    //
+//                                                                            //
+//   fully associative among all lines, giving hits for every capacity. The  //
+//                     stack is never walked: the distance is a Fenwick tree  //
+//                     prefix sum over access slots, O(log n) per access.     //
+//                                                                            //
+// Writebacks are skipped: CRC_CACHE fills a missing writeback at MRU but     //
+// leaves a hitting one in place, which is not a stack algorithm. Compare     //
+// against a CRC_CACHE fed the same trace without its writebacks.             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_trace.h"
+#include "crc_tag_match.h"
+
+// Hash of a line address, also used to pick sampled lines
+static inline unsigned long long CRC_HashLine( Addr_t line )
+{
+    // 64-bit finalizer of MurmurHash3
+    line ^= line >> 33;
+    line *= 0xff51afd7ed558ccdULL;
+    line ^= line >> 33;
+    line *= 0xc4ceb9fe1a85ec53ULL;
+    line ^= line >> 33;
+    return line;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Open addressing hash map from line address to a COUNTER                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class CRC_LINE_MAP
+{
+  private:
+
+    Addr_t  *keys;
+    COUNTER *values;
+    size_t   mask;      // capacity-1
+    size_t   count;
+
+  public:
+
+    CRC_LINE_MAP();
+    ~CRC_LINE_MAP();
+
+    // Returns a pointer to the value of line, or NULL if it is not present
+    COUNTER *Find( Addr_t line );
+
+    // Insert or overwrite
+    void     Set( Addr_t line, COUNTER value );
+
+    void     Erase( Addr_t line );
+
+    size_t   Size() { return count; }
+
+  private:
+
+    size_t   Slot( Addr_t line );
+    void     Grow();
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Fenwick tree over access slots. Every access takes the next slot; a line   //
+// keeps only the slot of its last access marked. The number of marked       //
+// slots after a line's slot is its fully associative stack distance. When   //
+// the slots run out the marked ones are renumbered from 0 (and the array     //
+// doubled if more than half are marked), so memory tracks the footprint     //
+// rather than the trace length.                                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class CRC_REUSE_COUNTER
+{
+  private:
+
+    UINT32  *tree;          // Fenwick tree, 1-based, capacity entries
+    Addr_t  *slotLine;      // line whose last access is in the slot, or empty
+    size_t   capacity;
+    size_t   next;          // next free slot
+    size_t   marked;
+
+  public:
+
+    CRC_REUSE_COUNTER();
+    ~CRC_REUSE_COUNTER();
+
+    // Distinct lines accessed after the given slot
+    size_t  CountAfter( size_t slot );
+
+    // Unmark the slot of a line's previous access
+    void    Release( size_t slot );
+
+    // Mark a new slot for line and return it. Compaction moves other lines,
+    // so their slots in lineSlots are updated here.
+    size_t  Append( Addr_t line, CRC_LINE_MAP &lineSlots );
+
+  private:
+
+    void    Add( size_t slot, INT32 delta );
+    void    Compact( CRC_LINE_MAP &lineSlots );
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The stack distance engine                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class CRC_STACK_DISTANCE
+{
+  private:
+
+    UINT32 numsets;
+    UINT32 linesize;
+    UINT32 maxWays;
+
+    // Lookup Parameters
+    UINT32 lineShift;
+    UINT32 indexMask;
+
+    // per set: the maxWays most recently used lines, MRU first, padded
+    // with CRC_INVALID_TAG
+    Addr_t           *setStack;
+    CRC_TAG_MATCH_FN  match;
+
+    CRC_LINE_MAP       lastUse;     // line -> slot of its last access
+    CRC_REUSE_COUNTER  reuse;
+
+    // setHist[d]: accesses at per-set distance d (d < maxWays)
+    COUNTER  *setHist;
+
+    // faHist[d]: accesses at fully associative distance d
+    COUNTER  *faHist;
+    size_t    faHistSize;
+
+    COUNTER   accesses;
+    COUNTER   writebacks;
+
+  public:
+
+    CRC_STACK_DISTANCE( UINT32 _sets, UINT32 _linesize, UINT32 _maxWays );
+    ~CRC_STACK_DISTANCE();
+
+    void    Reference( const Access &req );
+
+    UINT32  NumSets()  { return numsets; }
+    UINT32  MaxWays()  { return maxWays; }
+
+    COUNTER Accesses()      { return accesses; }
+    COUNTER Writebacks()    { return writebacks; }
+    COUNTER DistinctLines() { return lastUse.Size(); }
+
+    // LRU hits of a numsets x ways cache
+    COUNTER SetAssocHits( UINT32 ways );
+
+    // LRU hits of a fully associative cache of the given number of lines
+    COUNTER FullyAssocHits( COUNTER lines );
+
+    // Write both curves as text
+    void    WriteCurve( FILE *out );
+
+};
+
+#endif
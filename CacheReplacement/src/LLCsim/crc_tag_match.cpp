@@ -0,0 +1,181 @@
+#include <cassert>
+#include "crc_tag_match.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Portable kernel: compare way by way                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static INT32 TagMatchScalar( const Addr_t *setTags, UINT32 assoc, Addr_t tag )
+{
+    for(UINT32 way=0; way<assoc; way++)
+    {
+        if( setTags[way] == tag )
+        {
+            return way;
+        }
+    }
+
+    return -1;
+}
+
+#ifdef CRC_X86_KERNELS
+
+// The vector kernels build the match mask of a whole set before looking at
+// it. A sentinel bit above the last way turns "no match" into an
+// out-of-range way, so a set costs no branch beyond the final select and an
+// unpredictable hit/miss pattern stays cheap. Sets wider than 32 ways are
+// matched 32 ways at a time.
+#define CRC_TAG_MATCH_CHUNK 32
+
+static inline INT32 TagMatchResult( WAYMASK mask, UINT32 ways )
+{
+    INT32 way = __builtin_ctzll( mask | (1ULL << ways) );
+
+    return (way < (INT32)ways) ? way : -1;
+}
+
+static INT32 TagMatchWide( CRC_TAG_MATCH_FN match, const Addr_t *setTags, UINT32 assoc, Addr_t tag )
+{
+    for(UINT32 base=0; base<assoc; base+=CRC_TAG_MATCH_CHUNK)
+    {
+        UINT32 ways = (assoc - base < CRC_TAG_MATCH_CHUNK) ? assoc - base : CRC_TAG_MATCH_CHUNK;
+        INT32  hit  = match( setTags + base, ways, tag );
+
+        if( hit != -1 )
+        {
+            return base + hit;
+        }
+    }
+
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// SSE4.2 kernel: two tags per compare                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+__attribute__((target("sse4.2")))
+static INT32 TagMatchSSE42( const Addr_t *setTags, UINT32 assoc, Addr_t tag )
+{
+    if( assoc > CRC_TAG_MATCH_CHUNK )
+    {
+        return TagMatchWide( TagMatchSSE42, setTags, assoc, tag );
+    }
+
+    __m128i key  = _mm_set1_epi64x( tag );
+    WAYMASK mask = 0;
+    UINT32  way  = 0;
+
+    for(; way+2<=assoc; way+=2)
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)(setTags + way) );
+
+        mask |= (WAYMASK)_mm_movemask_pd( _mm_castsi128_pd( _mm_cmpeq_epi64( a, key ) ) ) << way;
+    }
+
+    if( way < assoc )
+    {
+        mask |= (WAYMASK)(setTags[way] == tag) << way;
+    }
+
+    return TagMatchResult( mask, assoc );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// AVX2 kernel: four tags per compare, so a 16-way set takes four compares    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static INT32 TagMatchAVX2( const Addr_t *setTags, UINT32 assoc, Addr_t tag )
+{
+    if( assoc > CRC_TAG_MATCH_CHUNK )
+    {
+        return TagMatchWide( TagMatchAVX2, setTags, assoc, tag );
+    }
+
+    __m256i key  = _mm256_set1_epi64x( tag );
+    WAYMASK mask = 0;
+    UINT32  way  = 0;
+
+    for(; way+4<=assoc; way+=4)
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i *)(setTags + way) );
+
+        mask |= (WAYMASK)_mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpeq_epi64( a, key ) ) ) << way;
+    }
+
+    for(; way<assoc; way++)
+    {
+        mask |= (WAYMASK)(setTags[way] == tag) << way;
+    }
+
+    return TagMatchResult( mask, assoc );
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Kernel selection                                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CRC_TagMatchSupported( UINT32 kernel )
+{
+    switch( kernel )
+    {
+      case CRC_TAG_MATCH_SCALAR:
+        return true;
+#ifdef CRC_X86_KERNELS
+      case CRC_TAG_MATCH_SSE42:
+        return __builtin_cpu_supports( "sse4.2" );
+      case CRC_TAG_MATCH_AVX2:
+        return __builtin_cpu_supports( "avx2" );
+#endif
+      default:
+        return false;
+    }
+}
+
+UINT32 CRC_TagMatchBest()
+{
+    UINT32 kernel = CRC_TAG_MATCH_MAX - 1;
+
+    while( !CRC_TagMatchSupported( kernel ) )
+    {
+        kernel--;
+    }
+
+    return kernel;
+}
+
+CRC_TAG_MATCH_FN CRC_TagMatchFunction( UINT32 kernel )
+{
+    assert( CRC_TagMatchSupported( kernel ) );
+
+    switch( kernel )
+    {
+#ifdef CRC_X86_KERNELS
+      case CRC_TAG_MATCH_SSE42:
+        return TagMatchSSE42;
+      case CRC_TAG_MATCH_AVX2:
+        return TagMatchAVX2;
+#endif
+      default:
+        return TagMatchScalar;
+    }
+}
+
+const char *CRC_TagMatchName( UINT32 kernel )
+{
+    static const char *names[ CRC_TAG_MATCH_MAX ] = { "scalar", "sse4.2", "avx2" };
+
+    return (kernel < CRC_TAG_MATCH_MAX) ? names[ kernel ] : "unknown";
+}
@@ -0,0 +1,40 @@
+#ifndef CRC_TAG_MATCH_H
+#define CRC_TAG_MATCH_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Tag match kernels for CRC_TAG_STORE.                                       //
+//                                                                            //
+// A kernel compares a tag against all ways of one set and returns the way   //
+// that holds it, or -1. The vector kernels compare four (AVX2) or two        //
+// (SSE4.2) 64-bit tags per instruction, fold the compare results into a      //
+// bitmask with movemask and pick the hit way with a count-trailing-zeros.    //
+// The best kernel the host supports is picked at run time through CPUID.     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "utils.h"
+
+// Bitmask with one bit per way of a set (up to 64 ways)
+#define WAYMASK     unsigned long long
+
+typedef INT32 (*CRC_TAG_MATCH_FN)( const Addr_t *setTags, UINT32 assoc, Addr_t tag );
+
+typedef enum
+{
+    CRC_TAG_MATCH_SCALAR = 0,
+    CRC_TAG_MATCH_SSE42  = 1,
+    CRC_TAG_MATCH_AVX2   = 2,
+    CRC_TAG_MATCH_MAX    = 3
+} TagMatchKernel;
+
+// Is the kernel supported by the host CPU?
+bool              CRC_TagMatchSupported( UINT32 kernel );
+
+// Fastest kernel supported by the host CPU
+UINT32            CRC_TagMatchBest();
+
+CRC_TAG_MATCH_FN  CRC_TagMatchFunction( UINT32 kernel );
+const char       *CRC_TagMatchName( UINT32 kernel );
+
+#endif
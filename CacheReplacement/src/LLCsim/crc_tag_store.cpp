@@ -0,0 +1,128 @@
+#include "crc_tag_store.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The constructor allocates the per-line arrays for all sets of the cache    //
+// and starts off with every line invalid                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_TAG_STORE::CRC_TAG_STORE( UINT32 _sets, UINT32 _assoc )
+{
+    numsets = _sets;
+    assoc   = _assoc;
+
+    // the per-set valid/dirty bitmasks hold one bit per way
+    assert(assoc <= 64);
+
+    size_t lines = (size_t)numsets * assoc;
+
+    tags      = (Addr_t *)    CRC_AlignedAlloc( lines * sizeof(Addr_t) );
+    sharing   = (BITVECTOR *) CRC_AlignedAlloc( lines * sizeof(BITVECTOR) );
+    validMask = (WAYMASK *)   CRC_AlignedAlloc( numsets * sizeof(WAYMASK) );
+    dirtyMask = (WAYMASK *)   CRC_AlignedAlloc( numsets * sizeof(WAYMASK) );
+    setView   = new LINE_STATE[ assoc ];
+
+    // ensure that we were able to create the tag store
+    assert(tags && sharing && validMask && dirtyMask && setView);
+
+    fullMask = (assoc == 64) ? ~0ULL : ((1ULL << assoc) - 1);
+
+    for(size_t i=0; i<lines; i++)
+    {
+        tags[i]    = CRC_INVALID_TAG;
+        sharing[i] = 0;
+    }
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+    {
+        validMask[ setIndex ] = 0;
+        dirtyMask[ setIndex ] = 0;
+    }
+
+    SetTagMatchKernel( CRC_TagMatchBest() );
+}
+
+CRC_TAG_STORE::~CRC_TAG_STORE()
+{
+    CRC_AlignedFree( tags );
+    CRC_AlignedFree( sharing );
+    CRC_AlignedFree( validMask );
+    CRC_AlignedFree( dirtyMask );
+
+    delete [] setView;
+}
+
+void CRC_TAG_STORE::SetTagMatchKernel( UINT32 kernel )
+{
+    matchKernel = kernel;
+    match       = CRC_TagMatchFunction( kernel );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function copies all ways of a set into LINE_STATE records so that     //
+// replacement policies can inspect the set through the contestant            //
+// interface. The view is only valid until the next call.                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+const LINE_STATE *CRC_TAG_STORE::SetView( UINT32 setIndex )
+{
+    size_t base = Base( setIndex );
+
+    for(UINT32 way=0; way<assoc; way++)
+    {
+        setView[way].valid       = (validMask[ setIndex ] >> way) & 1;
+        setView[way].tag         = tags[ base + way ];
+        setView[way].dirty       = (dirtyMask[ setIndex ] >> way) & 1;
+        setView[way].sharing_dir = sharing[ base + way ];
+    }
+
+    return setView;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function copies a single line into a LINE_STATE record. The view is    //
+// only valid until the next call.                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+const LINE_STATE *CRC_TAG_STORE::LineView( UINT32 setIndex, UINT32 way )
+{
+    size_t i = Base( setIndex ) + way;
+
+    lineView.valid       = (validMask[ setIndex ] >> way) & 1;
+    lineView.tag         = tags[i];
+    lineView.dirty       = (dirtyMask[ setIndex ] >> way) & 1;
+    lineView.sharing_dir = sharing[i];
+
+    return &lineView;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Whole-cache occupancy: popcounts over the per-set bitmasks                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+COUNTER CRC_TAG_STORE::ValidLineCount() const
+{
+    COUNTER count = 0;
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+    {
+        count += SetValidCount( setIndex );
+    }
+
+    return count;
+}
+
+COUNTER CRC_TAG_STORE::DirtyLineCount() const
+{
+    COUNTER count = 0;
+
+    for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+    {
+        count += SetDirtyCount( setIndex );
+    }
+
+    return count;
+}
@@ -0,0 +1,149 @@
+#ifndef CRC_TAG_STORE_H
+#define CRC_TAG_STORE_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Flat tag store used by CRC_CACHE.                                          //
+//                                                                            //
+// The tags and sharing vectors of every line are kept in separate           //
+// contiguous arrays indexed by set*assoc+way, each aligned to a 64-byte      //
+// host cache line. A set lookup therefore walks one dense run of tags        //
+// instead of chasing a per-set pointer into 24-byte LINE_STATE records.      //
+// Valid and dirty bits are kept as one bitmask per set, so finding an        //
+// invalid way is a single ctz and occupancy/dirty counts are a popcount.     //
+// Policies that want to inspect a set through the LINE_STATE interface get   //
+// a view materialized on demand.                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <cassert>
+#include "utils.h"
+#include "crc_cache_defs.h"
+#include "crc_tag_match.h"
+
+#define CRC_HOST_LINE_SIZE 64
+
+// Tag held by invalid lines. Real tags are shifted right by at least the
+// line offset bits, so they can never be all ones and a lookup only has to
+// compare tags.
+#define CRC_INVALID_TAG    (~0ULL)
+
+// Allocate/free memory aligned to a host cache line
+static inline void *CRC_AlignedAlloc( size_t bytes )
+{
+    void *p = NULL;
+
+    if( posix_memalign( &p, CRC_HOST_LINE_SIZE, bytes ? bytes : 1 ) != 0 ) return NULL;
+    return p;
+}
+
+static inline void CRC_AlignedFree( void *p )
+{
+    free( p );
+}
+
+class CRC_TAG_STORE
+{
+  private:
+
+    UINT32 numsets;
+    UINT32 assoc;
+
+    Addr_t     *tags;
+    BITVECTOR  *sharing;
+    WAYMASK    *validMask;    // per set: bit w set if way w is valid
+    WAYMASK    *dirtyMask;    // per set: bit w set if way w is dirty
+    WAYMASK     fullMask;     // all ways of a set
+
+    // tag match kernel used by Lookup
+    UINT32           matchKernel;
+    CRC_TAG_MATCH_FN match;
+
+    // scratch LINE_STATE copies handed out through the view functions
+    LINE_STATE *setView;
+    LINE_STATE  lineView;
+
+  public:
+
+    CRC_TAG_STORE( UINT32 _sets, UINT32 _assoc );
+    ~CRC_TAG_STORE();
+
+    // Returns the way holding tag in the set, or -1 if it is not present
+    INT32 Lookup( UINT32 setIndex, Addr_t tag ) const
+    {
+        return match( tags + Base( setIndex ), assoc, tag );
+    }
+
+    // Returns the first invalid way in the set, or -1 if the set is full
+    INT32 FindInvalid( UINT32 setIndex ) const
+    {
+        WAYMASK invalid = ~validMask[ setIndex ] & fullMask;
+
+        return invalid ? __builtin_ctzll( invalid ) : -1;
+    }
+
+    // Install a new line in the given way. Returns true if a dirty line was
+    // evicted to make room for it.
+    bool Fill( UINT32 setIndex, UINT32 way, Addr_t tag, bool isDirty, BITVECTOR sharers )
+    {
+        size_t  i       = Base( setIndex ) + way;
+        WAYMASK wayBit  = 1ULL << way;
+        bool    evicted = (dirtyMask[ setIndex ] & wayBit) != 0;
+
+        validMask[ setIndex ] |= wayBit;
+        dirtyMask[ setIndex ]  = (dirtyMask[ setIndex ] & ~wayBit) | ((WAYMASK)isDirty << way);
+        tags[i]                = tag;
+        sharing[i]             = sharers;
+
+        return evicted;
+    }
+
+    // Record a hit on the line in the given way
+    void Touch( UINT32 setIndex, UINT32 way, bool isDirty, BITVECTOR sharers )
+    {
+        dirtyMask[ setIndex ]             |= (WAYMASK)isDirty << way;
+        sharing[ Base( setIndex ) + way ] |= sharers;
+    }
+
+    // Pull the host cache lines holding a set's tags, sharing vectors and
+    // valid/dirty masks towards the core ahead of a lookup
+    void PrefetchSet( UINT32 setIndex ) const
+    {
+        const char *t = (const char *)( tags + Base( setIndex ) );
+        const char *s = (const char *)( sharing + Base( setIndex ) );
+
+        for(size_t off=0; off<assoc*sizeof(Addr_t); off+=CRC_HOST_LINE_SIZE)
+        {
+            __builtin_prefetch( t + off, 0, 3 );
+        }
+
+        for(size_t off=0; off<assoc*sizeof(BITVECTOR); off+=CRC_HOST_LINE_SIZE)
+        {
+            __builtin_prefetch( s + off, 1, 3 );
+        }
+
+        __builtin_prefetch( validMask + setIndex, 1, 3 );
+        __builtin_prefetch( dirtyMask + setIndex, 1, 3 );
+    }
+
+    // Occupancy of a set and of the whole cache
+    UINT32  SetValidCount( UINT32 setIndex ) const { return __builtin_popcountll( validMask[ setIndex ] ); }
+    UINT32  SetDirtyCount( UINT32 setIndex ) const { return __builtin_popcountll( dirtyMask[ setIndex ] ); }
+    COUNTER ValidLineCount() const;
+    COUNTER DirtyLineCount() const;
+
+    // Select the tag match kernel (defaults to the best the host supports)
+    void   SetTagMatchKernel( UINT32 kernel );
+    UINT32 GetTagMatchKernel() const { return matchKernel; }
+
+    const LINE_STATE *SetView( UINT32 setIndex );
+    const LINE_STATE *LineView( UINT32 setIndex, UINT32 way );
+
+  private:
+
+    size_t Base( UINT32 setIndex ) const { return (size_t)setIndex * assoc; }
+
+};
+
+#endif
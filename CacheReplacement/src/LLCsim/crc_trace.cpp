@@ -0,0 +1,150 @@
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "crc_trace.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Writer: a placeholder header goes out first and is rewritten on Close     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_TRACE_WRITER::CRC_TRACE_WRITER( const char *path )
+{
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, CRC_TRACE_MAGIC, sizeof(header.magic) );
+    header.version = CRC_TRACE_VERSION;
+
+    fp = fopen( path, "wb" );
+    ok = fp && fwrite( &header, sizeof(header), 1, fp ) == 1;
+}
+
+CRC_TRACE_WRITER::~CRC_TRACE_WRITER()
+{
+    Close();
+}
+
+void CRC_TRACE_WRITER::Write( const Access *reqs, size_t n )
+{
+    if( !ok ) return;
+
+    for(size_t i=0; i<n; i++)
+    {
+        if( reqs[i].tid >= header.threads ) header.threads = reqs[i].tid + 1;
+    }
+
+    ok = fwrite( reqs, sizeof(Access), n, fp ) == n;
+    header.records += n;
+}
+
+bool CRC_TRACE_WRITER::Close()
+{
+    if( !fp ) return ok;
+
+    if( ok )
+    {
+        ok = fseek( fp, 0, SEEK_SET ) == 0 && fwrite( &header, sizeof(header), 1, fp ) == 1;
+    }
+
+    ok = (fclose( fp ) == 0) && ok;
+    fp = NULL;
+
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Reader                                                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_TRACE_READER::CRC_TRACE_READER( const char *path )
+{
+    memset( &header, 0, sizeof(header) );
+
+    fp = fopen( path, "rb" );
+    ok = fp && fread( &header, sizeof(header), 1, fp ) == 1
+            && !memcmp( header.magic, CRC_TRACE_MAGIC, sizeof(header.magic) )
+            && header.version == CRC_TRACE_VERSION;
+
+    if( !ok ) header.records = 0;
+}
+
+CRC_TRACE_READER::~CRC_TRACE_READER()
+{
+    if( fp ) fclose( fp );
+}
+
+size_t CRC_TRACE_READER::Read( Access *reqs, size_t max )
+{
+    if( !ok ) return 0;
+
+    return fread( reqs, sizeof(Access), max, fp );
+}
+
+void CRC_TRACE_READER::Rewind()
+{
+    if( ok ) ok = fseek( fp, sizeof(header), SEEK_SET ) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Mapping: the file is mapped read-only and marked sequential, so the kernel //
+// reads ahead aggressively and drops pages behind the reader. A file cut     //
+// short of the records its header claims is an error, like a truncated gzip  //
+// trace: PresentRecords() tells how many it still holds.                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+CRC_TRACE_MAP::CRC_TRACE_MAP( const char *path )
+{
+    memset( &header, 0, sizeof(header) );
+
+    base    = NULL;
+    length  = 0;
+    present = 0;
+    ok      = false;
+
+    int fd = open( path, O_RDONLY );
+    if( fd < 0 ) return;
+
+    struct stat st;
+
+    if( fstat( fd, &st ) == 0 && (size_t)st.st_size >= sizeof(header) )
+    {
+        length = st.st_size;
+        base   = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        if( base == MAP_FAILED )
+        {
+            base   = NULL;
+            length = 0;
+        }
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    close( fd );
+
+    if( !base ) return;
+
+    madvise( base, length, MADV_SEQUENTIAL );
+
+    memcpy( &header, base, sizeof(header) );
+
+    ok = !memcmp( header.magic, CRC_TRACE_MAGIC, sizeof(header.magic) )
+            && header.version == CRC_TRACE_VERSION;
+
+    if( !ok )
+    {
+        header.records = 0;
+        return;
+    }
+
+    present = (length - sizeof(header)) / sizeof(Access);
+
+    if( present < header.records ) ok = false;
+}
+
+CRC_TRACE_MAP::~CRC_TRACE_MAP()
+{
+    if( base ) munmap( base, length );
+}
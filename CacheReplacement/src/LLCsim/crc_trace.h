@@ -0,0 +1,133 @@
+#ifndef CRC_TRACE_H
+#define CRC_TRACE_H
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// LLC access traces for the standalone tools.                                //
+//                                                                            //
+// A trace file is a CRC_TRACE_HEADER followed by the raw Access records in   //
+// host byte order. The writer fills in the record and thread counts when it  //
+// is closed. Errors are reported through Ok(); a reader that fails to open   //
+// or finds a bad header simply returns no records, and a mapping of a file   //
+// holding fewer records than its header claims is not Ok() either.           //
+//                                                                            //
+// Layout (little endian on x86, all fields naturally aligned):               //
+//                                                                            //
+//   offset  size  header                                                     //
+//        0     8  magic "CRCTRACE"                                           //
+//        8     4  version (1)                                                //
+//       12     4  threads: highest tid + 1                                   //
+//       16     8  records                                                    //
+//                                                                            //
+//   24 + 24 * i   record i (Access)                                          //
+//        +0    4  tid                                                        //
+//        +4    4  accessType (ACCESS_IFETCH .. ACCESS_WRITEBACK)             //
+//        +8    8  PC                                                         //
+//       +16    8  paddr                                                      //
+//                                                                            //
+// CRC_TRACE_READER streams records through stdio; CRC_TRACE_MAP maps the     //
+// whole file and hands out the records in place.                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include "utils.h"
+#include "crc_cache_defs.h"
+
+// One LLC access: a trace record, and what CRC_CACHE::LookupAndFillBatch
+// takes
+typedef struct
+{
+    UINT32      tid;         // Thread id
+    UINT32      accessType;  // One of AccessTypes
+    Addr_t      PC;          // PC of the instruction causing the access
+    Addr_t      paddr;       // Physical address
+} Access;
+
+#define CRC_TRACE_MAGIC    "CRCTRACE"
+#define CRC_TRACE_VERSION  1
+
+typedef struct
+{
+    char        magic[8];    // CRC_TRACE_MAGIC
+    UINT32      version;     // CRC_TRACE_VERSION
+    UINT32      threads;     // highest thread id + 1
+    COUNTER     records;     // number of Access records that follow
+} CRC_TRACE_HEADER;
+
+class CRC_TRACE_WRITER
+{
+  private:
+
+    FILE             *fp;
+    CRC_TRACE_HEADER  header;
+    bool              ok;
+
+  public:
+
+    CRC_TRACE_WRITER( const char *path );
+    ~CRC_TRACE_WRITER();
+
+    void Write( const Access *reqs, size_t n );
+
+    // Patch the header and close the file; returns false on any error
+    bool Close();
+
+    bool Ok() { return ok; }
+
+};
+
+class CRC_TRACE_READER
+{
+  private:
+
+    FILE             *fp;
+    CRC_TRACE_HEADER  header;
+    bool              ok;
+
+  public:
+
+    CRC_TRACE_READER( const char *path );
+    ~CRC_TRACE_READER();
+
+    // Read up to max records, returns how many were read (0 at the end)
+    size_t  Read( Access *reqs, size_t max );
+
+    // Start again from the first record
+    void    Rewind();
+
+    bool    Ok() { return ok; }
+    UINT32  Threads() { return header.threads; }
+    COUNTER Records() { return header.records; }
+
+};
+
+// Read-only mapping of a whole trace file, read front to back
+class CRC_TRACE_MAP
+{
+  private:
+
+    void             *base;
+    size_t            length;
+    CRC_TRACE_HEADER  header;
+    COUNTER           present;
+    bool              ok;
+
+  public:
+
+    CRC_TRACE_MAP( const char *path );
+    ~CRC_TRACE_MAP();
+
+    const Access *Records() { return ok ? (const Access *)( (const char *)base + sizeof(header) ) : NULL; }
+
+    bool    Ok() { return ok; }
+    UINT32  Threads() { return header.threads; }
+    COUNTER NumRecords() { return header.records; }
+    size_t  FileBytes() { return length; }
+
+    // Whole records in the file: below NumRecords() if it was truncated
+    COUNTER PresentRecords() { return present; }
+
+};
+
+#endif
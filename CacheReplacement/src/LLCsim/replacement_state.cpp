@@ -1,3 +1,4 @@
+#include <cstdio>
 #include "replacement_state.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,53 +39,690 @@ CACHE_REPLACEMENT_STATE::CACHE_REPLACEMENT_STATE( UINT32 _sets, UINT32 _assoc, U
     replPolicy = _pol;
 
     mytimer    = 0;
+    numThreads = 1;
+    lineShift  = 6;
+
+    globalSets = _sets;
+    shardCount = 1;
+    shardIndex = 0;
+
+    // Seed 1 yields the same sequence as rand() without a call to srand()
+    memset( &rng, 0, sizeof(rng) );
+    initstate_r( 1, rngState, sizeof(rngState), &rng );
+
+    shctBits          = CRC_SHIP_SHCT_BITS;
+    shipSignatureBits = CRC_SHIP_SIGNATURE_BITS;
+
+    optNextUse = NULL;
+    optRecords = 0;
+
+    duelLeaders       = CRC_DRRIP_LEADERS;
+    duelCounterBits   = CRC_DRRIP_COUNTER_BITS;
+    duelTraceInterval = 0;
+
+    instrument   = NULL;
+    instLineHits = NULL;
+    instPosition = CRC_INST_POSITION_NONE;
+
+    InitReplacementState();
+}
+
+CACHE_REPLACEMENT_STATE::~CACHE_REPLACEMENT_STATE()
+{
+    FreeReplacementState();
+
+    delete instrument;
+    delete [] instLineHits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The state is sized for the policy, so changing it means building the       //
+// state again; only allowed before the first access                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SetReplacementPolicy( UINT32 _pol )
+{
+    assert( mytimer == 0 );
+
+    FreeReplacementState();
+
+    replPolicy = _pol;
+
+    InitReplacementState();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function sizes the SHiP tables; like the policy, only before the       //
+// first access                                                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::ConfigureSHiP( UINT32 _shctBits, UINT32 _signatureBits )
+{
+    assert( mytimer == 0 );
+    assert( _shctBits >= 1 && _shctBits <= CRC_SHIP_MAX_BITS );
+    assert( _signatureBits >= 1 && _signatureBits <= CRC_SHIP_MAX_BITS );
+
+    FreeReplacementState();
+
+    shctBits          = _shctBits;
+    shipSignatureBits = _signatureBits;
+
+    InitReplacementState();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function sets the line size of the cache; the state does not depend    //
+// on it, so it is kept as is                                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SetLineSize( UINT32 _linesize )
+{
+    assert( mytimer == 0 );
+
+    lineShift = CRC_FloorLog2( _linesize );
+
+    // the perceptron splits line addresses into page and offset
+    assert( (1U << lineShift) == _linesize && lineShift <= CRC_MPP_PAGE_BITS );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function sets the number of threads sharing the cache, which places    //
+// the DRRIP leader sets; like the policy, only before the first access       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SetNumThreads( UINT32 _threads )
+{
+    assert( mytimer == 0 );
+    assert( _threads >= 1 && _threads <= CRC_DUEL_MAX_THREADS );
+
+    if( _threads == numThreads ) return;
+
+    FreeReplacementState();
+
+    numThreads = _threads;
+
+    InitReplacementState();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function makes this state hold every shards-th set of a larger cache;  //
+// the sets held are numsets, the leader and sampled sets those of a cache    //
+// of _globalSets sets. Like the policy, only before the first access.        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SetInterleave( UINT32 _globalSets, UINT32 _shards, UINT32 _shard )
+{
+    assert( mytimer == 0 );
+    assert( _shard < _shards && (unsigned long long)numsets * _shards == _globalSets );
+
+    FreeReplacementState();
+
+    globalSets = _globalSets;
+    shardCount = _shards;
+    shardIndex = _shard;
+
+    InitReplacementState();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function configures the DRRIP set dueling; like the policy, only       //
+// before the first access                                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::ConfigureDueling( UINT32 _leaders, UINT32 _counterBits, COUNTER _traceInterval )
+{
+    assert( mytimer == 0 );
+    assert( _leaders >= 1 );
+    assert( _counterBits >= 1 && _counterBits <= CRC_DUEL_MAX_BITS );
+
+    FreeReplacementState();
+
+    duelLeaders       = _leaders;
+    duelCounterBits   = _counterBits;
+    duelTraceInterval = _traceInterval;
 
     InitReplacementState();
 }
 
+void CACHE_REPLACEMENT_STATE::SetNextUse( const unsigned long long *entries, COUNTER records )
+{
+    assert( mytimer == 0 );
+
+    optNextUse = entries;
+    optRecords = records;
+}
+
+CRC_PREDICTOR_TABLE CACHE_REPLACEMENT_STATE::Predictor()
+{
+    CRC_PREDICTOR_TABLE table;
+
+    memset( &table, 0, sizeof(table) );
+
+    if( shct ) 
+    {
+        table.entries = shct;
+        table.size    = (size_t)1 << shctBits;
+        table.max     = CRC_SHIP_SHCT_MAX;
+        table.flags   = CRC_SHIP_SHCT_USED;
+    }
+    else if( hawkPredictor ) 
+    {
+        table.entries = hawkPredictor;
+        table.size    = (size_t)1 << CRC_HAWKEYE_PREDICTOR_BITS;
+        table.max     = CRC_HAWKEYE_COUNTER_MAX;
+    }
+    else if( sdbpTables ) 
+    {
+        table.entries = sdbpTables;
+        table.size    = CRC_SDBP_TABLES << CRC_SDBP_TABLE_BITS;
+        table.max     = CRC_SDBP_COUNTER_MAX;
+    }
+    else if( mppWeights ) 
+    {
+        table.entries  = (unsigned char *)mppWeights;
+        table.size     = CRC_MPP_FEATURES << CRC_MPP_TABLE_BITS;
+        table.isSigned = true;
+        table.min      = CRC_MPP_WEIGHT_MIN;
+        table.max      = CRC_MPP_WEIGHT_MAX;
+    }
+
+    return table;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function registers the probes: accesses, misses, bypasses and          //
+// evictions, hits of a line before its eviction, where lines are inserted    //
+// and evicted if the policy orders them, the selector of every thread under  //
+// DRRIP and the recency targets under ARC                                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::EnableInstrumentation( COUNTER interval )
+{
+    assert( CRC_INSTRUMENT_BUILT );
+    assert( mytimer == 0 && !instrument );
+
+    instrument   = new CRC_INSTRUMENTATION( interval );
+    instLineHits = new unsigned char[ (size_t)numsets * assoc ];
+
+    memset( instLineHits, 0, (size_t)numsets * assoc );
+
+    instAccesses  = instrument->AddCounter( "accesses" );
+    instMisses    = instrument->AddCounter( "misses" );
+    instBypasses  = instrument->AddCounter( "bypasses" );
+    instEvictions = instrument->AddCounter( "evictions" );
+    instHits      = instrument->AddHistogram( "hits_before_eviction", CRC_INST_HIT_BINS );
+
+    instPosition = CRC_INST_POSITION_NONE;
+
+    if( rrpv ) instPosition = CRC_INST_POSITION_RRPV;
+    else if( hawkRRPV ) instPosition = CRC_INST_POSITION_HAWKEYE;
+    else if( lruOrder || lruBytes ) instPosition = CRC_INST_POSITION_STACK;
+
+    if( instPosition == CRC_INST_POSITION_RRPV ) 
+    {
+        instInsertion = instrument->AddHistogram( "insertion_rrpv", RRIP_MAX );
+        instEviction  = instrument->AddHistogram( "eviction_rrpv", RRIP_MAX );
+    }
+    else if( instPosition == CRC_INST_POSITION_HAWKEYE ) 
+    {
+        // friendly ranks 0 to assoc-1, then averse
+        instInsertion = instrument->AddHistogram( "insertion_rrpv", assoc + 1 );
+        instEviction  = instrument->AddHistogram( "eviction_rrpv", assoc + 1 );
+    }
+    else if( instPosition == CRC_INST_POSITION_STACK ) 
+    {
+        instInsertion = instrument->AddHistogram( "insertion_stack_position", assoc );
+        instEviction  = instrument->AddHistogram( "eviction_stack_position", assoc );
+    }
+
+    if( duel ) 
+    {
+        char name[32];
+
+        for(UINT32 t=0; t<numThreads; t++) 
+        {
+            sprintf( name, "psel.t%u", t );
+            UINT32 probe = instrument->AddGauge( name );
+
+            if( t == 0 ) instPsel = probe;
+        }
+    }
+
+    if( replPolicy == CRC_REPL_ARC ) instArcTarget = instrument->AddGauge( "arc.target_lines" );
+}
+
+// The probes, with the gauges read now
+CRC_INSTRUMENTATION *CACHE_REPLACEMENT_STATE::Instrumentation()
+{
+    if( instrument ) InstrumentGauges();
+
+    return instrument;
+}
+
+void CACHE_REPLACEMENT_STATE::InstrumentGauges()
+{
+    if( duel ) 
+    {
+        // the root of the thread's tournament; with two policies its only counter
+        UINT32 perThread = duel->NumCounters() / numThreads;
+
+        for(UINT32 t=0; t<numThreads; t++) instrument->Set( instPsel + t, duel->GetCounter( t * perThread ) );
+    }
+
+    if( replPolicy == CRC_REPL_ARC ) instrument->Set( instArcTarget, arcTargetSum );
+}
+
+void CACHE_REPLACEMENT_STATE::FreeReplacementState()
+{
+    delete duel;
+    delete [] lruOrder;
+    delete [] lruBytes;
+    delete [] rrpv;
+    delete [] lineSignature;
+    delete [] shipFlags;
+    delete [] shct;
+    delete [] hawkRRPV;
+    delete [] hawkPredictor;
+    delete [] hawkTags;
+    delete [] hawkTimes;
+    delete [] hawkSignatures;
+    delete [] hawkOccupancy;
+    delete [] hawkTime;
+    delete [] optLineNext;
+    delete [] recencyBits;
+    delete [] plruPath;
+    delete [] plruSet;
+    delete [] eafFilter;
+    delete [] sdbpDead;
+    delete [] sdbpTables;
+    delete [] sdbpTags;
+    delete [] sdbpSignatures;
+    delete [] sdbpPosition;
+    delete [] mppWeights;
+    delete [] mppHistory;
+    delete [] mppTags;
+    delete [] mppIndices;
+    delete [] mppPosition;
+    delete [] arcFrequent;
+    delete [] arcTarget;
+    delete [] arcGhosts;
+    delete [] arcGhostHead;
+    delete [] arcTrace;
+
+    duel          = NULL;
+    lruOrder      = NULL;
+    lruBytes      = NULL;
+    rrpv          = NULL;
+    lineSignature = NULL;
+    shipFlags     = NULL;
+    shct          = NULL;
+    hawkRRPV      = NULL;
+    hawkPredictor = NULL;
+    hawkTags       = NULL;
+    hawkTimes      = NULL;
+    hawkSignatures = NULL;
+    hawkOccupancy  = NULL;
+    hawkTime       = NULL;
+    optLineNext    = NULL;
+    recencyBits    = NULL;
+    plruPath       = NULL;
+    plruSet        = NULL;
+    eafFilter      = NULL;
+    sdbpDead       = NULL;
+    sdbpTables     = NULL;
+    sdbpTags       = NULL;
+    sdbpSignatures = NULL;
+    sdbpPosition   = NULL;
+    mppWeights     = NULL;
+    mppHistory     = NULL;
+    mppTags        = NULL;
+    mppIndices     = NULL;
+    mppPosition    = NULL;
+    arcFrequent    = NULL;
+    arcTarget      = NULL;
+    arcGhosts      = NULL;
+    arcGhostHead   = NULL;
+    arcTrace       = NULL;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
 // This function initializes the replacement policy hardware by creating      //
-// storage for the replacement state on a per-line/per-cache basis.           //
+// storage for the replacement state on a per-line/per-cache basis. Only the  //
+// state of the selected policy is allocated, each kind in one flat array.    //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
 void CACHE_REPLACEMENT_STATE::InitReplacementState()
 {
-    // Create the state for sets, then create the state for the ways
-    repl  = new LINE_REPLACEMENT_STATE* [ numsets ];
+    duel      = NULL;
+    lruOrder  = NULL;
+    lruBytes  = NULL;
+    rrpv      = NULL;
+    rrpvWords = 0;
 
-    // ensure that we were able to create replacement state
-    assert(repl);
+    lineSignature = NULL;
+    shipFlags     = NULL;
+    shct          = NULL;
+    hawkRRPV      = NULL;
+    hawkPredictor = NULL;
+    hawkTags       = NULL;
+    hawkTimes      = NULL;
+    hawkSignatures = NULL;
+    hawkOccupancy  = NULL;
+    hawkTime       = NULL;
+    hawkStride     = 1;
+    optLineNext    = NULL;
+    optBypasses    = 0;
+    recencyBits    = NULL;
+    plruPath       = NULL;
+    plruSet        = NULL;
+    eafFilter      = NULL;
+    sdbpDead       = NULL;
+    sdbpTables     = NULL;
+    sdbpTags       = NULL;
+    sdbpSignatures = NULL;
+    sdbpPosition   = NULL;
+    sdbpStride     = 1;
+    mppWeights     = NULL;
+    mppHistory     = NULL;
+    mppTags        = NULL;
+    mppIndices     = NULL;
+    mppPosition    = NULL;
+    mppStride      = 1;
+    arcFrequent    = NULL;
+    arcTarget      = NULL;
+    arcGhosts      = NULL;
+    arcGhostHead   = NULL;
+    arcTrace       = NULL;
 
-    if (this->replPolicy == CRC_REPL_CONTESTANT) {
-        hitpolicy = 0;
-        RRIP_MAX = 4;
+    if( replPolicy == CRC_REPL_ARC ) 
+    {
+        // the frequency bits of a set are one word; targets and ring slots
+        // are bytes
+        assert( assoc <= 64 );
+
+        // hardware bits per line: ghost entry, frequency bit, recency order
+        // and, shared by the set, the target and ring head
+        UINT32 orderBits = CRC_CeilLog2( assoc );
+        UINT32 lineBits  = CRC_ARC_GHOST_TAG_BITS + 2 + 1 + orderBits + (2 * (orderBits + 1) + assoc - 1) / assoc;
+
+        assert( lineBits <= CRC_ARC_BUDGET_BITS );
+
+        arcFrequent  = new unsigned long long[ numsets ];
+        arcTarget    = new unsigned char[ numsets ];
+        arcGhosts    = new unsigned short[ (size_t)numsets * assoc ];
+        arcGhostHead = new unsigned char[ numsets ];
+
+        memset( arcFrequent, 0, numsets * sizeof(unsigned long long) );
+        memset( arcTarget, 0, numsets );
+        memset( arcGhosts, 0, (size_t)numsets * assoc * sizeof(unsigned short) );
+        memset( arcGhostHead, 0, numsets );
+
+        arcLines         = 0;
+        arcFrequentLines = 0;
+        arcTargetSum     = 0;
+        memset( arcGhostHits, 0, sizeof(arcGhostHits) );
+        memset( arcEvictions, 0, sizeof(arcEvictions) );
+
+        arcIntervalAccesses = 0;
+        arcIntervalRecent   = 0;
+        arcIntervalTarget   = 0;
+        arcRecords          = 0;
+        arcCapacity         = 0;
     }
 
-    LeaderSets = 32;
+    if( replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS ) 
+    {
+        // the dead ways of a set are one word
+        assert( assoc <= 64 );
+
+        sdbpStride  = (globalSets > CRC_SDBP_SAMPLER_SETS) ? globalSets / CRC_SDBP_SAMPLER_SETS : 1;
+        sdbpSampled = (globalSets + sdbpStride - 1) / sdbpStride;
 
-    BL = 0;
-    SL = 0;
-    BI = 0;
-    SI = 0;
+        size_t entries = (size_t)sdbpSampled * assoc;
 
-    EPSILON = 16;
-    PS_MAX = 1024;
-    PS = PS_MAX / 2;
+        sdbpDead       = new unsigned long long[ numsets ];
+        sdbpTables     = new unsigned char[ CRC_SDBP_TABLES << CRC_SDBP_TABLE_BITS ];
+        sdbpTags       = new unsigned short[ entries ];
+        sdbpSignatures = new unsigned short[ entries ];
+        sdbpPosition   = new unsigned char[ entries ];
+
+        memset( sdbpDead, 0, numsets * sizeof(unsigned long long) );
+        memset( sdbpTables, 0, CRC_SDBP_TABLES << CRC_SDBP_TABLE_BITS );
+        memset( sdbpTags, 0, entries * sizeof(unsigned short) );
+        memset( sdbpSignatures, 0, entries * sizeof(unsigned short) );
+        memset( sdbpPosition, assoc, entries );
+
+        memset( sdbpFills, 0, sizeof(sdbpFills) );
+        memset( sdbpEvictions, 0, sizeof(sdbpEvictions) );
+        sdbpFalseDead = 0;
+        sdbpBypasses  = 0;
+    }
+
+    if( replPolicy == CRC_REPL_TREE_PLRU || replPolicy == CRC_REPL_NRU ) 
+    {
+        assert( assoc <= CRC_RECENCY_MAX_WAYS );
+
+        // tree-PLRU: the tree has plruLeaves - 1 inner nodes
+        for(plruLeaves=1, plruLevels=0; plruLeaves<assoc; plruLeaves<<=1, plruLevels++);
+
+        UINT32 bits = (replPolicy == CRC_REPL_NRU) ? assoc : plruLeaves - 1;
+
+        for(recencyWidth=0; (1U << recencyWidth) < bits; recencyWidth++);
+
+        recencyFields = 6 - recencyWidth;
+        recencyMask   = (recencyWidth == 6) ? ~0ULL : (1ULL << (1 << recencyWidth)) - 1;
+        nruWays       = (assoc == 64) ? ~0ULL : (1ULL << assoc) - 1;
+
+        size_t words = ((size_t)numsets + (1 << recencyFields) - 1) >> recencyFields;
+
+        recencyBits = new unsigned long long[ words ];
+        memset( recencyBits, 0, words * sizeof(unsigned long long) );
+    }
 
-    // Create the state for the sets
-    for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+    if( replPolicy == CRC_REPL_TREE_PLRU ) 
     {
-        repl[ setIndex ]  = new LINE_REPLACEMENT_STATE[ assoc ];
+        plruPath = new unsigned long long[ assoc ];
+        plruSet  = new unsigned long long[ assoc ];
 
         for(UINT32 way=0; way<assoc; way++) 
         {
-            // initialize stack position (for true LRU)
-            repl[ setIndex ][ way ].LRUstackposition = way;
-            repl[setIndex][way].RRPV = RRIP_MAX - 1;
+            plruPath[ way ] = 0;
+            plruSet[ way ]  = 0;
+
+            for(UINT32 child=plruLeaves + way; child>1; child>>=1) 
+            {
+                UINT32 node  = child >> 1;
+                UINT32 first = 2 * node + 1;
+
+                // the first leaf under the right child
+                while( first < plruLeaves ) first <<= 1;
+
+                plruPath[ way ] |= 1ULL << (node - 1);
+
+                // a left child points the node right, unless the right
+                // child is padding only
+                if( !(child & 1) && first - plruLeaves < assoc ) plruSet[ way ] |= 1ULL << (node - 1);
+            }
+        }
+    }
+
+    if( replPolicy == CRC_REPL_OPT || replPolicy == CRC_REPL_OPT_BYPASS ) 
+    {
+        optLineNext = new unsigned long long[ (size_t)numsets * assoc ];
+        memset( optLineNext, 0, (size_t)numsets * assoc * sizeof(unsigned long long) );
+    }
+
+    if( replPolicy == CRC_REPL_HAWKEYE ) 
+    {
+        // OPTgen on 1 in hawkStride sets; predictor counters start weakly
+        // friendly, lines start averse
+        hawkStride  = (globalSets > CRC_HAWKEYE_SAMPLED_SETS) ? globalSets / CRC_HAWKEYE_SAMPLED_SETS : 1;
+        hawkSampled = (globalSets + hawkStride - 1) / hawkStride;
+        hawkWindow  = CRC_HAWKEYE_HISTORY * assoc;
+
+        // the occupancy of a quantum and the friendly ranks stay below
+        // CRC_HAWKEYE_RRPV_MAX
+        assert( assoc < CRC_HAWKEYE_RRPV_MAX );
+
+        hawkRRPV      = new unsigned char[ (size_t)numsets * assoc ];
+        lineSignature = new unsigned short[ (size_t)numsets * assoc ];
+        hawkPredictor = new unsigned char[ 1 << CRC_HAWKEYE_PREDICTOR_BITS ];
+        hawkTime       = new UINT32[ hawkSampled ];
+        hawkTags       = new Addr_t[ (size_t)hawkSampled * hawkWindow ];
+        hawkTimes      = new UINT32[ (size_t)hawkSampled * hawkWindow ];
+        hawkSignatures = new unsigned short[ (size_t)hawkSampled * hawkWindow ];
+        hawkOccupancy  = new unsigned char[ (size_t)hawkSampled * hawkWindow ];
+        hawkMatch      = CRC_TagMatchFunction( CRC_TagMatchBest() );
+
+        memset( hawkRRPV, CRC_HAWKEYE_RRPV_MAX, (size_t)numsets * assoc );
+        memset( lineSignature, 0, (size_t)numsets * assoc * sizeof(unsigned short) );
+        memset( hawkPredictor, CRC_HAWKEYE_FRIENDLY, 1 << CRC_HAWKEYE_PREDICTOR_BITS );
+        memset( hawkTime, 0, hawkSampled * sizeof(UINT32) );
+        memset( hawkTimes, 0, (size_t)hawkSampled * hawkWindow * sizeof(UINT32) );
+        memset( hawkSignatures, 0, (size_t)hawkSampled * hawkWindow * sizeof(unsigned short) );
+        memset( hawkOccupancy, 0, (size_t)hawkSampled * hawkWindow );
+
+        for(size_t i=0; i<(size_t)hawkSampled * hawkWindow; i++) hawkTags[i] = CRC_HAWKEYE_NO_TAG;
+
+        memset( hawkInserts, 0, sizeof(hawkInserts) );
+        memset( hawkDecisions, 0, sizeof(hawkDecisions) );
+        memset( hawkAgree, 0, sizeof(hawkAgree) );
+        hawkDetrains = 0;
+    }
+
+    if( replPolicy == CRC_REPL_LRU || replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS ||
+        replPolicy == CRC_REPL_ARC ) 
+    {
+        // initialize the true LRU stacks: way i at stack position i
+
+        // ways are named by one byte in the unpacked order
+        assert( assoc <= 256 );
+
+        if( assoc <= CRC_LRU_PACKED_WAYS ) 
+        {
+            unsigned long long identity = 0;
+
+            for(UINT32 way=0; way<assoc; way++) identity |= (unsigned long long)way << (4 * way);
+
+            lruOrder = new unsigned long long[ numsets ];
+            for(UINT32 setIndex=0; setIndex<numsets; setIndex++) lruOrder[ setIndex ] = identity;
+        }
+        else 
+        {
+            lruBytes = new unsigned char[ (size_t)numsets * assoc ];
+
+            for(UINT32 setIndex=0; setIndex<numsets; setIndex++) 
+            {
+                for(UINT32 way=0; way<assoc; way++) lruBytes[ (size_t)setIndex * assoc + way ] = way;
+            }
         }
     }
 
+    if (this->replPolicy == CRC_REPL_CONTESTANT || this->replPolicy == CRC_REPL_SHIP || this->replPolicy == CRC_REPL_EAF ||
+        this->replPolicy == CRC_REPL_PERCEPTRON) {
+        hitpolicy = 0;
+        RRIP_MAX = 4;
+    }
+
+    EPSILON = 16;
+
+    if( replPolicy != CRC_REPL_CONTESTANT && replPolicy != CRC_REPL_SHIP && replPolicy != CRC_REPL_EAF &&
+        replPolicy != CRC_REPL_PERCEPTRON ) return;
+
+    // the RRPVs are 2-bit fields
+    assert( RRIP_MAX == (1 << CRC_RRPV_BITS) );
+
+    // Every way starts at RRIP_MAX-1; fields past assoc in the last word of
+    // a set stay 0
+    UINT32 lastWays = assoc - (assoc - 1) / CRC_RRPV_PER_WORD * CRC_RRPV_PER_WORD;
+
+    rrpvWords    = (assoc + CRC_RRPV_PER_WORD - 1) / CRC_RRPV_PER_WORD;
+    rrpvLastMask = CRC_RRPV_LOW_BITS >> (CRC_RRPV_BITS * (CRC_RRPV_PER_WORD - lastWays));
+    rrpv         = new UINT32[ (size_t)numsets * rrpvWords ];
+
+    for(size_t w=0; w<(size_t)numsets * rrpvWords; w++) 
+    {
+        UINT32 fields = ((w + 1) % rrpvWords) ? CRC_RRPV_LOW_BITS : rrpvLastMask;
+        rrpv[w] = (RRIP_MAX - 1) * fields;
+    }
+
+    if( replPolicy == CRC_REPL_SHIP ) 
+    {
+        // SHCT counters start at 1, so that new signatures are not all
+        // predicted dead (and so evicted before they could train up)
+        shct          = new unsigned char[ (size_t)1 << shctBits ];
+        lineSignature = new unsigned short[ (size_t)numsets * assoc ];
+        shipFlags     = new unsigned char[ (size_t)numsets * assoc ];
+
+        memset( shct, 1, (size_t)1 << shctBits );
+        memset( lineSignature, 0, (size_t)numsets * assoc * sizeof(unsigned short) );
+        memset( shipFlags, 0, (size_t)numsets * assoc );
+
+        memset( shipInserts, 0, sizeof(shipInserts) );
+        memset( shipEvictions, 0, sizeof(shipEvictions) );
+
+        return;
+    }
+
+    if( replPolicy == CRC_REPL_EAF ) 
+    {
+        // at least one word; the hashes take the top eafBits bits
+        for(eafBits=6; ((size_t)1 << eafBits) < (size_t)numsets * assoc * CRC_EAF_BITS_PER_LINE; eafBits++);
+
+        eafFilter  = new unsigned long long[ ((size_t)1 << eafBits) / 64 ];
+        memset( eafFilter, 0, ((size_t)1 << eafBits) / 8 );
+
+        eafInserts = 0;
+        eafClears  = 0;
+        memset( eafFills, 0, sizeof(eafFills) );
+
+        return;
+    }
+
+    if( replPolicy == CRC_REPL_PERCEPTRON ) 
+    {
+        // sampler LRU positions are bytes
+        assert( assoc < 256 );
+
+        mppStride  = (globalSets > CRC_MPP_SAMPLER_SETS) ? globalSets / CRC_MPP_SAMPLER_SETS : 1;
+        mppSampled = (globalSets + mppStride - 1) / mppStride;
+
+        size_t entries = (size_t)mppSampled * assoc;
+
+        mppWeights  = new signed char[ CRC_MPP_FEATURES << CRC_MPP_TABLE_BITS ];
+        mppHistory  = new Addr_t[ numThreads * CRC_MPP_HISTORY ];
+        mppTags     = new unsigned short[ entries ];
+        mppIndices  = new unsigned short[ entries * CRC_MPP_FEATURES ];
+        mppPosition = new unsigned char[ entries ];
+
+        memset( mppWeights, 0, CRC_MPP_FEATURES << CRC_MPP_TABLE_BITS );
+        memset( mppHistory, 0, numThreads * CRC_MPP_HISTORY * sizeof(Addr_t) );
+        memset( mppTags, 0, entries * sizeof(unsigned short) );
+        memset( mppIndices, 0, entries * CRC_MPP_FEATURES * sizeof(unsigned short) );
+        memset( mppPosition, assoc, entries );
+
+        memset( mppInserts, 0, sizeof(mppInserts) );
+        memset( mppHelps, 0, sizeof(mppHelps) );
+        memset( mppHurts, 0, sizeof(mppHurts) );
+        mppTrainings = 0;
+        mppCorrect   = 0;
+        mppUpdates   = 0;
+
+        return;
+    }
+
+    // DRRIP: SRRIP against BRRIP, in hashed leader sets of every thread
+    duel = new CRC_SET_DUELING( globalSets, 2, numThreads, duelLeaders, duelCounterBits );
+    duel->SetTraceInterval( duelTraceInterval );
+
     // Contestants:  ADD INITIALIZATION FOR YOUR HARDWARE HERE
 
 }
@@ -121,6 +759,42 @@ INT32 CACHE_REPLACEMENT_STATE::GetVictimInSet( UINT32 tid, UINT32 setIndex, cons
         // Contestants:  ADD YOUR VICTIM SELECTION FUNCTION HERE
         return Get_DRRIP_Victim(setIndex);
     }
+    else if( replPolicy == CRC_REPL_SHIP )
+    {
+        return Get_DRRIP_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_HAWKEYE )
+    {
+        return Get_Hawkeye_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_OPT || replPolicy == CRC_REPL_OPT_BYPASS )
+    {
+        return Get_OPT_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_TREE_PLRU )
+    {
+        return Get_TreePLRU_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_NRU )
+    {
+        return Get_NRU_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_EAF )
+    {
+        return Get_EAF_Victim( setIndex, vicSet );
+    }
+    else if( replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS )
+    {
+        return Get_SDBP_Victim( setIndex, PC, accessType );
+    }
+    else if( replPolicy == CRC_REPL_PERCEPTRON )
+    {
+        return Get_DRRIP_Victim( setIndex );
+    }
+    else if( replPolicy == CRC_REPL_ARC )
+    {
+        return Get_ARC_Victim( setIndex, vicSet );
+    }
 
     // We should never get here
     assert(0);
@@ -128,6 +802,60 @@ INT32 CACHE_REPLACEMENT_STATE::GetVictimInSet( UINT32 tid, UINT32 setIndex, cons
     return -1; // Returning -1 bypasses the LLC
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The cache keeps its lines in a flat tag store and only builds the          //
+// LINE_STATE copies passed as vicSet to GetVictimInSet and as currLine to    //
+// UpdateReplacementState when the policy says it reads them. Return true     //
+// here for any policy that looks at either; otherwise both are NULL.         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CACHE_REPLACEMENT_STATE::InspectsLineState()
+{
+    // LRU, Random, DRRIP, SHiP, tree-PLRU and NRU only use their own
+    // replacement state; Hawkeye follows line tags through OPTgen, SDBP
+    // through its sampler, EAF and ARC remember the addresses of evicted
+    // lines and the perceptron hashes them
+    return replPolicy == CRC_REPL_HAWKEYE || replPolicy == CRC_REPL_EAF ||
+           replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS ||
+           replPolicy == CRC_REPL_PERCEPTRON || replPolicy == CRC_REPL_ARC;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function tells whether the set is a set-dueling leader of the policy:  //
+// its misses train global state, so a cache that only simulates some of its  //
+// sets must always simulate this one                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+bool CACHE_REPLACEMENT_STATE::IsLeaderSet( UINT32 setIndex )
+{
+    if( replPolicy == CRC_REPL_CONTESTANT ) 
+    {
+        return duel->IsLeader( GlobalSet( setIndex ) );
+    }
+
+    // OPTgen trains the Hawkeye predictor on its sampled sets
+    if( replPolicy == CRC_REPL_HAWKEYE ) 
+    {
+        return IsHawkeyeSampled( setIndex );
+    }
+
+    // and the SDBP sampler, which also keeps these sets from bypassing
+    if( replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS ) 
+    {
+        return IsSdbpSampled( setIndex );
+    }
+
+    // and the perceptron sampler
+    if( replPolicy == CRC_REPL_PERCEPTRON ) 
+    {
+        return IsMppSampled( setIndex );
+    }
+
+    return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
 // This function is called by the cache after every cache hit/miss            //
@@ -156,7 +884,43 @@ void CACHE_REPLACEMENT_STATE::UpdateReplacementState(
         // Contestants:  ADD YOUR UPDATE REPLACEMENT STATE FUNCTION HERE
         // Feel free to use any of the input parameters to make
         // updates to your replacement policy
-        UpdateDRRIP(setIndex, updateWayID, cacheHit);
+        UpdateDRRIP(setIndex, updateWayID, tid, cacheHit);
+    }
+    else if( replPolicy == CRC_REPL_SHIP )
+    {
+        UpdateSHiP( setIndex, updateWayID, PC, cacheHit );
+    }
+    else if( replPolicy == CRC_REPL_HAWKEYE )
+    {
+        UpdateHawkeye( setIndex, updateWayID, currLine, PC, accessType, cacheHit );
+    }
+    else if( replPolicy == CRC_REPL_OPT || replPolicy == CRC_REPL_OPT_BYPASS )
+    {
+        UpdateOPT( setIndex, updateWayID );
+    }
+    else if( replPolicy == CRC_REPL_TREE_PLRU )
+    {
+        UpdateTreePLRU( setIndex, updateWayID );
+    }
+    else if( replPolicy == CRC_REPL_NRU )
+    {
+        UpdateNRU( setIndex, updateWayID );
+    }
+    else if( replPolicy == CRC_REPL_EAF )
+    {
+        UpdateEAF( setIndex, updateWayID, currLine, cacheHit );
+    }
+    else if( replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS )
+    {
+        UpdateSDBP( setIndex, updateWayID, currLine, PC, accessType, cacheHit );
+    }
+    else if( replPolicy == CRC_REPL_PERCEPTRON )
+    {
+        UpdatePerceptron( setIndex, updateWayID, currLine, tid, PC, accessType, cacheHit );
+    }
+    else if( replPolicy == CRC_REPL_ARC )
+    {
+        UpdateARC( setIndex, updateWayID, currLine, cacheHit );
     }
     
     
@@ -164,156 +928,362 @@ void CACHE_REPLACEMENT_STATE::UpdateReplacementState(
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-//////// HELPER FUNCTIONS FOR REPLACEMENT UPDATE AND VICTIM SELECTION //////////
+// One access to a sampled set, by its tag and PC signature. On a sampler     //
+// hit the previous signature of the line was wrong to call it dead, if it    //
+// did, and trains live; on a miss the LRU line of the sampler set (after     //
+// any invalid one) makes room and trains its signature dead. Either way the  //
+// line moves to the top of the sampler's LRU stack with the new signature.   //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::SdbpSample( UINT32 setIndex, Addr_t tag, UINT32 signature )
+{
+    size_t          base      = (size_t)(GlobalSet( setIndex ) / sdbpStride) * assoc;
+    unsigned short *tags      = &sdbpTags[ base ];
+    unsigned short *sigs      = &sdbpSignatures[ base ];
+    unsigned char  *position  = &sdbpPosition[ base ];
+    unsigned short  partial   = (unsigned short)((tag ^ (tag >> CRC_SDBP_TAG_BITS)) & ((1 << CRC_SDBP_TAG_BITS) - 1));
+    INT32           way       = -1;
+
+    for(UINT32 w=0; w<assoc; w++) 
+    {
+        if( position[w] < assoc && tags[w] == partial ) way = w;
+    }
+
+    if( way != -1 ) 
+    {
+        SdbpTrain( sigs[ way ], false );
+    }
+    else 
+    {
+        // the invalid entries sit below the bottom of the stack
+        for(UINT32 w=0; w<assoc; w++) 
+        {
+            if( way == -1 || position[w] > position[ way ] ) way = w;
+        }
+
+        if( position[ way ] < assoc ) SdbpTrain( sigs[ way ], true );
+
+        tags[ way ] = partial;
+    }
+
+    for(UINT32 w=0; w<assoc; w++) 
+    {
+        if( position[w] < position[ way ] ) position[w]++;
+    }
+
+    position[ way ] = 0;
+    sigs[ way ]     = signature;
+}
+
+void CACHE_REPLACEMENT_STATE::SdbpTrain( UINT32 signature, bool dead )
+{
+    for(UINT32 t=0; t<CRC_SDBP_TABLES; t++) 
+    {
+        unsigned char &counter = sdbpTables[ (t << CRC_SDBP_TABLE_BITS) + SdbpIndex( signature, t ) ];
 
+        if( dead && counter < CRC_SDBP_COUNTER_MAX ) counter++;
+        if( !dead && counter > 0 ) counter--;
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function finds the LRU victim in the cache set by returning the       //
-// cache block at the bottom of the LRU stack. Top of LRU stack is '0'        //
-// while bottom of LRU stack is 'assoc-1'                                     //
+// One access to a perceptron sampler set, by its tag and weight indices.     //
+// Like SdbpSample: a sampler hit trains the indices of the line's previous   //
+// access towards reuse, the line evicted to make room on a miss trains       //
+// those of its last access towards dead.                                     //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::Get_LRU_Victim( UINT32 setIndex )
+void CACHE_REPLACEMENT_STATE::MppSample( UINT32 setIndex, Addr_t tag, const unsigned short *indices )
 {
-    // Get pointer to replacement state of current set
-    LINE_REPLACEMENT_STATE *replSet = repl[ setIndex ];
+    size_t          base     = (size_t)(GlobalSet( setIndex ) / mppStride) * assoc;
+    unsigned short *tags     = &mppTags[ base ];
+    unsigned char  *position = &mppPosition[ base ];
+    unsigned short  partial  = (unsigned short)((tag ^ (tag >> CRC_MPP_TAG_BITS)) & ((1 << CRC_MPP_TAG_BITS) - 1));
+    INT32           way      = -1;
 
-    INT32   lruWay   = 0;
+    for(UINT32 w=0; w<assoc; w++) 
+    {
+        if( position[w] < assoc && tags[w] == partial ) way = w;
+    }
 
-    // Search for victim whose stack position is assoc-1
-    for(UINT32 way=0; way<assoc; way++) 
+    if( way != -1 ) 
+    {
+        MppTrain( &mppIndices[ (base + way) * CRC_MPP_FEATURES ], false );
+    }
+    else 
     {
-        if( replSet[way].LRUstackposition == (assoc-1) ) 
+        // the invalid entries sit below the bottom of the stack
+        for(UINT32 w=0; w<assoc; w++) 
         {
-            lruWay = way;
-            break;
+            if( way == -1 || position[w] > position[ way ] ) way = w;
         }
+
+        if( position[ way ] < assoc ) MppTrain( &mppIndices[ (base + way) * CRC_MPP_FEATURES ], true );
+
+        tags[ way ] = partial;
     }
 
-    // return lru way
-    return lruWay;
+    for(UINT32 w=0; w<assoc; w++) 
+    {
+        if( position[w] < position[ way ] ) position[w]++;
+    }
+
+    position[ way ] = 0;
+    memcpy( &mppIndices[ (base + way) * CRC_MPP_FEATURES ], indices, CRC_MPP_FEATURES * sizeof(unsigned short) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function finds a random victim in the cache set                       //
+// Perceptron training on one sampler outcome: unless the sum already called  //
+// it right by a margin of CRC_MPP_TRAIN, every weight it selects moves one   //
+// step towards the outcome. Before that, the outcome scores each feature:    //
+// whether the prediction would have been right without its weight.           //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-INT32 CACHE_REPLACEMENT_STATE::Get_Random_Victim( UINT32 setIndex )
+void CACHE_REPLACEMENT_STATE::MppTrain( const unsigned short *indices, bool dead )
 {
-    INT32 way = (rand() % assoc);
-    
-    return way;
-}
+    INT32 sum     = MppSum( indices );
+    bool  correct = (sum >= CRC_MPP_DEAD) == dead;
+
+    mppTrainings++;
+    mppCorrect += correct;
 
+    for(UINT32 f=0; f<CRC_MPP_FEATURES; f++) 
+    {
+        bool without = (sum - mppWeights[ indices[f] ] >= CRC_MPP_DEAD) == dead;
 
+        mppHelps[f] += correct && !without;
+        mppHurts[f] += !correct && without;
+    }
 
-INT32 CACHE_REPLACEMENT_STATE::Get_DRRIP_Victim(UINT32 setIndex) {
-    LINE_REPLACEMENT_STATE *replacementSet = repl[setIndex];
-    INT32 result = -1;
+    INT32 margin = dead ? sum - CRC_MPP_DEAD : CRC_MPP_DEAD - 1 - sum;
 
-    while (1) {
-        for(UINT32 way=0; way < assoc; way++)  {
-            if (replacementSet[way].RRPV == RRIP_MAX - 1) {
-                result = way;
-                break;
-            }
-        }
-        if (result >= 0) 
-            break;
-        
-        for(UINT32 way=0; way < assoc; way++)
-            replacementSet[way].RRPV++;
+    if( correct && margin >= CRC_MPP_TRAIN ) return;
+
+    mppUpdates++;
+
+    for(UINT32 f=0; f<CRC_MPP_FEATURES; f++) 
+    {
+        signed char &weight = mppWeights[ indices[f] ];
+
+        if( dead && weight < CRC_MPP_WEIGHT_MAX ) weight++;
+        if( !dead && weight > CRC_MPP_WEIGHT_MIN ) weight--;
     }
-    return result;
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
-// This function implements the LRU update routine for the traditional        //
-// LRU replacement policy. The arguments to the function are the physical     //
-// way and set index.                                                         //
+// An ARC miss filled into a way. A ghost entry of the line, if any, moves    //
+// the target towards the partition it was evicted from and is dropped, and   //
+// the line joins the frequency partition; otherwise it joins the recency     //
+// partition.                                                                 //
 //                                                                            //
 ////////////////////////////////////////////////////////////////////////////////
-void CACHE_REPLACEMENT_STATE::UpdateLRU( UINT32 setIndex, INT32 updateWayID )
+void CACHE_REPLACEMENT_STATE::ArcMiss( UINT32 setIndex, INT32 updateWayID, Addr_t tag )
 {
-    // Determine current LRU stack position
-    UINT32 currLRUstackposition = repl[ setIndex ][ updateWayID ].LRUstackposition;
+    unsigned short *ghosts  = &arcGhosts[ (size_t)setIndex * assoc ];
+    unsigned short  partial = ArcGhostTag( tag );
+    INT32           found   = -1;
+    UINT32          counts[2] = { 0, 0 };
 
-    // Update the stack position of all lines before the current line
-    // Update implies incremeting their stack positions by one
-    for(UINT32 way=0; way<assoc; way++) 
+    for(UINT32 g=0; g<assoc; g++) 
     {
-        if( repl[setIndex][way].LRUstackposition < currLRUstackposition ) 
-        {
-            repl[setIndex][way].LRUstackposition++;
-        }
+        if( !(ghosts[g] & CRC_ARC_GHOST_VALID) ) continue;
+
+        counts[ (ghosts[g] & CRC_ARC_GHOST_FREQUENT) != 0 ]++;
+        if( (ghosts[g] & ~CRC_ARC_GHOST_FREQUENT) == partial ) found = g;
     }
 
-    // Set the LRU stack position of new line to be zero
-    repl[ setIndex ][ updateWayID ].LRUstackposition = 0;
-}
+    unsigned long long way = 1ULL << updateWayID;
 
+    arcLines++;
 
-void CACHE_REPLACEMENT_STATE::UpdateSRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit) {
-    LINE_REPLACEMENT_STATE *replacementSet = repl[setIndex];
-    if (cacheHit)
-        if(hitpolicy) {
-            if (replacementSet[updateWayID].RRPV > 0)
-                replacementSet[updateWayID].RRPV--;
-        }
-        else 
-            replacementSet[updateWayID].RRPV = 0;
-    else
-        replacementSet[updateWayID].RRPV = RRIP_MAX - 2;
+    if( found == -1 ) 
+    {
+        arcFrequent[ setIndex ] &= ~way;
+        return;
+    }
+
+    bool           frequent = (ghosts[ found ] & CRC_ARC_GHOST_FREQUENT) != 0;
+    UINT32         step     = frequent ? counts[0] / counts[1] : counts[1] / counts[0];
+    unsigned char &target   = arcTarget[ setIndex ];
+    UINT32         before   = target;
+
+    if( step < 1 ) step = 1;
+
+    if( frequent ) target = (target > step) ? target - step : 0;
+    else target = (target + step < assoc) ? target + step : assoc;
+
+    arcTargetSum += target;
+    arcTargetSum -= before;
+
+    arcGhostHits[ frequent ]++;
+    ghosts[ found ] = 0;
+
+    arcFrequent[ setIndex ] |= way;
+    arcFrequentLines++;
 }
 
-void CACHE_REPLACEMENT_STATE::UpdateBRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit) {
-    LINE_REPLACEMENT_STATE *replacementSet = repl[setIndex];
-    if (cacheHit)
-        if (hitpolicy) {
-            if (replacementSet[updateWayID].RRPV > 0) 
-                replacementSet[updateWayID].RRPV--;
-        }
-        else 
-            replacementSet[updateWayID].RRPV = 0;
-    else {
-        UINT32 randnum = rand() % EPSILON;
-        if (randnum == EPSILON - 1) 
-            replacementSet[updateWayID].RRPV = RRIP_MAX - 2;
-        else 
-            replacementSet[updateWayID].RRPV = RRIP_MAX - 1;
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Keep the average split of the interval just ended; the record array        //
+// doubles when full                                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::ArcRecordInterval()
+{
+    if( arcRecords == arcCapacity ) 
+    {
+        COUNTER capacity = arcCapacity ? 2 * arcCapacity : 64;
+        double *trace    = new double[ 2 * capacity ];
+
+        if( arcRecords ) memcpy( trace, arcTrace, 2 * arcRecords * sizeof(double) );
+
+        delete [] arcTrace;
+
+        arcTrace    = trace;
+        arcCapacity = capacity;
     }
+
+    arcTrace[ 2 * arcRecords ]     = arcIntervalRecent / arcIntervalAccesses;
+    arcTrace[ 2 * arcRecords + 1 ] = arcIntervalTarget / arcIntervalAccesses;
+    arcRecords++;
+
+    arcIntervalAccesses = 0;
+    arcIntervalRecent   = 0;
+    arcIntervalTarget   = 0;
 }
 
-void CACHE_REPLACEMENT_STATE::UpdateDRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit) {
-    if (((setIndex % 33) == 0) && (setIndex < LeaderSets * 33)) {
-        UpdateSRRIP(setIndex, updateWayID, cacheHit);
-        if (!cacheHit) {
-            if(PS > 0) 
-                PS--;
-            BL++;
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// OPTgen for one access to a sampled set. Time runs in accesses to the set;  //
+// occupancy[q] counts the lines OPT keeps cached across quantum q. A line    //
+// last used at t0 and used again now would have been kept by OPT if every    //
+// quantum from t0 up to now still had room for it, in which case it takes    //
+// that room. The verdict trains the PC of the earlier access.                //
+//                                                                            //
+// The history is a ring of the last hawkWindow accesses, so the slot of the  //
+// current access holds the one hawkWindow accesses ago: if that line has not //
+// come back since, its reuse (if any) is out of reach and OPT would have     //
+// missed it. A line that comes back clears its old slot. Each slot keeps the //
+// time of its access, and only a reuse less than hawkWindow accesses later   //
+// is judged on the occupancy vector.                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::HawkeyeOptgen( UINT32 setIndex, Addr_t tag, UINT32 signature )
+{
+    UINT32          sample     = GlobalSet( setIndex ) / hawkStride;
+    Addr_t         *tags       = &hawkTags[ (size_t)sample * hawkWindow ];
+    UINT32         *times      = &hawkTimes[ (size_t)sample * hawkWindow ];
+    unsigned short *signatures = &hawkSignatures[ (size_t)sample * hawkWindow ];
+    unsigned char  *occupancy  = &hawkOccupancy[ (size_t)sample * hawkWindow ];
+    UINT32          now        = hawkTime[ sample ]++;
+    UINT32          slot       = now % hawkWindow;
+    INT32           last       = hawkMatch( tags, hawkWindow, tag );
+
+    if( last != -1 && now - times[ last ] < hawkWindow ) 
+    {
+        bool optHit = true;
+
+        for(UINT32 q=last; optHit && q!=slot; q=(q + 1) % hawkWindow) 
+        {
+            if( occupancy[q] >= assoc ) optHit = false;
         }
-    } else if(((setIndex % 31) == 0) && (setIndex > 0) && (setIndex <= 31 * LeaderSets)) {
-        UpdateBRRIP(setIndex, updateWayID, cacheHit);
-        if (!cacheHit) {
-            if (PS < PS_MAX) 
-                PS++;
-            SL++;
+
+        if( optHit ) 
+        {
+            for(UINT32 q=last; q!=slot; q=(q + 1) % hawkWindow) occupancy[q]++;
         }
-    } else if (PS >= PS_MAX / 2) {
-        UpdateSRRIP(setIndex, updateWayID, cacheHit);
-        if (!cacheHit) 
-            SI++;
-    } else if (PS < PS_MAX / 2) {
-        UpdateBRRIP(setIndex, updateWayID, cacheHit);
-        if (!cacheHit) 
-            BI++;
+
+        HawkeyeTrain( signatures[ last ], optHit );
+        tags[ last ] = CRC_HAWKEYE_NO_TAG;
+    }
+
+    // the access leaving the window was never reused within it
+    if( tags[ slot ] != CRC_HAWKEYE_NO_TAG ) HawkeyeTrain( signatures[ slot ], false );
+
+    tags[ slot ]       = tag;
+    times[ slot ]      = now;
+    signatures[ slot ] = signature;
+    occupancy[ slot ]  = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Move the predictor counter of a PC towards OPT's verdict, after scoring    //
+// the prediction it would have made                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+void CACHE_REPLACEMENT_STATE::HawkeyeTrain( UINT32 signature, bool optHit )
+{
+    unsigned char &counter  = hawkPredictor[ signature ];
+    bool           friendly = counter >= CRC_HAWKEYE_FRIENDLY;
+
+    hawkDecisions[ optHit ]++;
+    if( friendly == optHit ) hawkAgree[ optHit ]++;
+
+    if( optHit ) 
+    {
+        if( counter < CRC_HAWKEYE_COUNTER_MAX ) counter++;
+    }
+    else if( counter > 0 ) 
+    {
+        counter--;
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//////// HELPER FUNCTIONS FOR REPLACEMENT UPDATE AND VICTIM SELECTION //////////
+//                                                                            //
+// The victim selection and update helpers are defined inline at the end of   //
+// replacement_state.h, next to the compile-time policy hooks that use them   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function adds up the replacement state allocated for the policy        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+size_t CACHE_REPLACEMENT_STATE::MetadataBytes()
+{
+    size_t bytes = 0;
+
+    if( duel )     bytes += duel->Bytes();
+    if( lruOrder ) bytes += (size_t)numsets * sizeof(unsigned long long);
+    if( lruBytes ) bytes += (size_t)numsets * assoc;
+    if( rrpv )     bytes += (size_t)numsets * rrpvWords * sizeof(UINT32);
+    if( shct )     bytes += ((size_t)1 << shctBits) + (size_t)numsets * assoc;
+    if( lineSignature ) bytes += (size_t)numsets * assoc * sizeof(unsigned short);
+    if( optLineNext ) bytes += (size_t)numsets * assoc * sizeof(unsigned long long);
+    if( eafFilter ) bytes += ((size_t)1 << eafBits) / 8;
+    if( arcFrequent ) 
+    {
+        bytes += (size_t)numsets * (sizeof(unsigned long long) + 2);
+        bytes += (size_t)numsets * assoc * sizeof(unsigned short);
+    }
+    if( mppWeights ) 
+    {
+        bytes += (CRC_MPP_FEATURES << CRC_MPP_TABLE_BITS) + numThreads * CRC_MPP_HISTORY * sizeof(Addr_t);
+        bytes += (size_t)mppSampled * assoc * ((CRC_MPP_FEATURES + 1) * sizeof(unsigned short) + 1);
+    }
+    if( sdbpDead ) 
+    {
+        bytes += (size_t)numsets * sizeof(unsigned long long) + (CRC_SDBP_TABLES << CRC_SDBP_TABLE_BITS);
+        bytes += (size_t)sdbpSampled * assoc * (2 * sizeof(unsigned short) + 1);
+    }
+    if( recencyBits ) bytes += (((size_t)numsets + (1 << recencyFields) - 1) >> recencyFields) * sizeof(unsigned long long);
+    if( hawkRRPV ) 
+    {
+        bytes += (size_t)numsets * assoc + (1 << CRC_HAWKEYE_PREDICTOR_BITS);
+        bytes += (size_t)hawkSampled * hawkWindow * (sizeof(Addr_t) + sizeof(UINT32) + sizeof(unsigned short) + 1);
+        bytes += hawkSampled * sizeof(UINT32);
+    }
+
+    return bytes;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
@@ -329,7 +1299,253 @@ ostream & CACHE_REPLACEMENT_STATE::PrintStats(ostream &out)
 
     // CONTESTANTS:  Insert your statistics printing here
 
+    size_t bytes = MetadataBytes();
+
+    out<<endl;
+    out<<"Replacement Metadata: "<<bytes<<" bytes ("<<(double)bytes / ((double)numsets * assoc)
+       <<" bytes per line)"<<endl;
+    out<<endl;
+
+    if( replPolicy == CRC_REPL_CONTESTANT ) PrintDRRIPStats( out );
+    if( replPolicy == CRC_REPL_SHIP ) PrintSHiPStats( out );
+    if( replPolicy == CRC_REPL_HAWKEYE ) PrintHawkeyeStats( out );
+    if( replPolicy == CRC_REPL_EAF ) PrintEAFStats( out );
+    if( replPolicy == CRC_REPL_SDBP || replPolicy == CRC_REPL_SDBP_BYPASS ) PrintSDBPStats( out );
+    if( replPolicy == CRC_REPL_PERCEPTRON ) PrintPerceptronStats( out );
+    if( replPolicy == CRC_REPL_ARC ) PrintARCStats( out );
+
+    if( replPolicy == CRC_REPL_OPT || replPolicy == CRC_REPL_OPT_BYPASS ) 
+    {
+        out<<"Belady OPT: "<<endl;
+        out<<endl;
+        out<<"\tNext-Use Index:  "<<optRecords<<" accesses"<<endl;
+        if( replPolicy == CRC_REPL_OPT_BYPASS ) out<<"\tBypasses:        "<<optBypasses<<endl;
+        out<<endl;
+    }
+
+    if( instrument ) Instrumentation()->PrintStats( out );
+
     return out;
     
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints, per thread, where its DRRIP selector ended up and     //
+// how its insertions and leader-set misses split between SRRIP and BRRIP     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintDRRIPStats( ostream &out )
+{
+    static const char *names[] = { "SRRIP", "BRRIP" };
+
+    out<<"TA-DRRIP: "<<endl;
+    out<<endl;
+
+    duel->PrintStats( out, names );
+    if( duelTraceInterval ) duel->PrintTrace( out, names );
+
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the SHiP table use and how well the insertion-time     //
+// prediction matched the fate of each line, judged when the line is          //
+// evicted (lines still in the cache are not counted)                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintSHiPStats( ostream &out )
+{
+    UINT32 entries = 1 << shctBits;
+    UINT32 used    = 0;
+    UINT32 dead    = 0;
+
+    for(UINT32 i=0; i<entries; i++) 
+    {
+        if( !(shct[i] & CRC_SHIP_SHCT_USED) ) continue;
+
+        used++;
+        if( !(shct[i] & CRC_SHIP_SHCT_MAX) ) dead++;
+    }
+
+    COUNTER inserts   = shipInserts[0] + shipInserts[1];
+    COUNTER evictions = shipEvictions[0][0] + shipEvictions[0][1] + shipEvictions[1][0] + shipEvictions[1][1];
+    COUNTER correct   = shipEvictions[0][1] + shipEvictions[1][0];
+
+    out<<"SHiP-PC: "<<endl;
+    out<<endl;
+    out<<"\tSHCT:            "<<entries<<" entries, "<<shipSignatureBits<<"-bit signatures"<<endl;
+    out<<"\tSHCT Occupancy:  "<<used<<" entries used ("<<100.0 * used / entries<<"%), "
+       <<dead<<" predicting no reuse"<<endl;
+    out<<"\tInserts:         "<<inserts<<" ("<<shipInserts[1]<<" distant, "<<shipInserts[0]<<" intermediate)"<<endl;
+    out<<"\tDistant:         "<<shipEvictions[1][0]<<" evicted unused, "<<shipEvictions[1][1]<<" reused"<<endl;
+    out<<"\tIntermediate:    "<<shipEvictions[0][1]<<" reused, "<<shipEvictions[0][0]<<" evicted unused"<<endl;
+    out<<"\tAccuracy:        "<<(evictions ? 100.0 * correct / evictions : 0)<<"% of "<<evictions<<" evicted lines"<<endl;
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the Hawkeye predictor use and its agreement with the   //
+// OPTgen verdicts it was trained on                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintHawkeyeStats( ostream &out )
+{
+    UINT32 entries  = 1 << CRC_HAWKEYE_PREDICTOR_BITS;
+    UINT32 friendly = 0;
+
+    for(UINT32 i=0; i<entries; i++) friendly += hawkPredictor[i] >= CRC_HAWKEYE_FRIENDLY;
+
+    COUNTER decisions = hawkDecisions[0] + hawkDecisions[1];
+    COUNTER agree     = hawkAgree[0] + hawkAgree[1];
+
+    out<<"Hawkeye: "<<endl;
+    out<<endl;
+    out<<"\tOPTgen:          "<<hawkSampled<<" sampled sets, "<<hawkWindow<<" accesses of history each"<<endl;
+    out<<"\tPredictor:       "<<entries<<" entries, "<<friendly<<" cache-friendly"<<endl;
+    out<<"\tInserts:         "<<hawkInserts[0] + hawkInserts[1]<<" ("<<hawkInserts[1]<<" friendly, "
+       <<hawkInserts[0]<<" averse)"<<endl;
+    out<<"\tDetrains:        "<<hawkDetrains<<" friendly lines evicted from sampled sets"<<endl;
+    out<<"\tOPT Hits:        "<<hawkDecisions[1]<<" ("<<hawkAgree[1]<<" predicted friendly)"<<endl;
+    out<<"\tOPT Misses:      "<<hawkDecisions[0]<<" ("<<hawkAgree[0]<<" predicted averse)"<<endl;
+    out<<"\tAccuracy:        "<<(decisions ? 100.0 * agree / decisions : 0)<<"% of "<<decisions
+       <<" OPTgen verdicts"<<endl;
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the size of the EAF filter, how often it was cleared   //
+// and how many fills it found evicted too early                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintEAFStats( ostream &out )
+{
+    COUNTER fills = eafFills[0] + eafFills[1];
+
+    out<<"EAF: "<<endl;
+    out<<endl;
+    out<<"\tFilter:          "<<((size_t)1 << eafBits)<<" bits, "<<CRC_EAF_HASHES<<" hashes, cleared every "
+       <<(COUNTER)numsets * assoc<<" evictions"<<endl;
+    out<<"\tClears:          "<<eafClears<<endl;
+    out<<"\tFills:           "<<fills<<" ("<<eafFills[1]<<" found in the filter, "
+       <<(fills ? 100.0 * eafFills[1] / fills : 0)<<"%)"<<endl;
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints how the SDBP dead predictions turned out. A line       //
+// predicted dead at its last access was right if it is evicted before its    //
+// next hit. Coverage is the share of evicted dead lines that were predicted  //
+// dead; the false positive rate the share of dead predictions proved wrong   //
+// by a hit. Bypassed lines are not followed.                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintSDBPStats( ostream &out )
+{
+    UINT32  entries   = CRC_SDBP_TABLES << CRC_SDBP_TABLE_BITS;
+    UINT32  saturated = 0;
+    COUNTER evictions = sdbpEvictions[0] + sdbpEvictions[1];
+    COUNTER predicted = sdbpEvictions[1] + sdbpFalseDead;
+
+    for(UINT32 i=0; i<entries; i++) saturated += sdbpTables[i] == CRC_SDBP_COUNTER_MAX;
+
+    out<<"SDBP: "<<endl;
+    out<<endl;
+    out<<"\tSampler:         "<<sdbpSampled<<" sets of "<<assoc<<" ways"<<endl;
+    out<<"\tPredictor:       "<<CRC_SDBP_TABLES<<" x "<<(1 << CRC_SDBP_TABLE_BITS)<<" counters, "
+       <<saturated<<" saturated dead"<<endl;
+    out<<"\tFills:           "<<sdbpFills[0] + sdbpFills[1]<<" ("<<sdbpFills[1]<<" predicted dead)"<<endl;
+    if( replPolicy == CRC_REPL_SDBP_BYPASS ) out<<"\tBypasses:        "<<sdbpBypasses<<endl;
+    out<<"\tEvictions:       "<<evictions<<" ("<<sdbpEvictions[1]<<" predicted dead, "
+       <<sdbpEvictions[0]<<" LRU)"<<endl;
+    out<<"\tCoverage:        "<<(evictions ? 100.0 * sdbpEvictions[1] / evictions : 0)<<"% of evicted lines"<<endl;
+    out<<"\tFalse Positives: "<<(predicted ? 100.0 * sdbpFalseDead / predicted : 0)<<"% of "<<predicted
+       <<" resolved dead predictions"<<endl;
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the perceptron insertions, its accuracy on the         //
+// sampler outcomes, and per feature an ablation: the outcomes predicted      //
+// right only thanks to its weight, and those it alone turned wrong. A        //
+// feature whose net is not clearly positive does not pay for its table.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintPerceptronStats( ostream &out )
+{
+    static const char *names[ CRC_MPP_FEATURES ] = { "PC", "PC History", "Page", "Page Offset", "Access Type", "Thread" };
+
+    out<<"Perceptron: "<<endl;
+    out<<endl;
+    out<<"\tWeights:         "<<CRC_MPP_FEATURES<<" x "<<(1 << CRC_MPP_TABLE_BITS)<<", "<<mppSampled
+       <<" sampled sets"<<endl;
+    out<<"\tInserts:         "<<mppInserts[0]<<" near, "<<mppInserts[1]<<" intermediate, "
+       <<mppInserts[2]<<" distant"<<endl;
+    out<<"\tAccuracy:        "<<(mppTrainings ? 100.0 * mppCorrect / mppTrainings : 0)<<"% of "<<mppTrainings
+       <<" sampler outcomes, "<<mppUpdates<<" trained"<<endl;
+    out<<"\tAblation:        outcomes right only with the feature / only without it (net % of outcomes)"<<endl;
+
+    for(UINT32 f=0; f<CRC_MPP_FEATURES; f++) 
+    {
+        double net = mppTrainings ? 100.0 * ((double)mppHelps[f] - (double)mppHurts[f]) / mppTrainings : 0;
+
+        out<<"\t  "<<names[f]<<": "<<mppHelps[f]<<" / "<<mppHurts[f]<<" ("<<net<<"%)"<<endl;
+    }
+
+    out<<endl;
+
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The function prints the ghost hits and evictions of each partition, and    //
+// for every interval of CRC_ARC_INTERVAL accesses the average share of the   //
+// cache in the recency partition and of the recency targets                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+ostream & CACHE_REPLACEMENT_STATE::PrintARCStats( ostream &out )
+{
+    UINT32 orderBits = CRC_CeilLog2( assoc );
+    double lineBits  = CRC_ARC_GHOST_TAG_BITS + 2 + 1 + orderBits + 2.0 * (orderBits + 1) / assoc;
+
+    out<<"ARC: "<<endl;
+    out<<endl;
+    out<<"\tState:           "<<lineBits<<" bits per line in hardware (budget "<<CRC_ARC_BUDGET_BITS<<"), "
+       <<assoc<<" ghost entries per set"<<endl;
+    out<<"\tGhost Hits:      "<<arcGhostHits[0]<<" recency, "<<arcGhostHits[1]<<" frequency"<<endl;
+    out<<"\tEvictions:       "<<arcEvictions[0]<<" recency, "<<arcEvictions[1]<<" frequency"<<endl;
+    out<<"\tSplit:           every "<<CRC_ARC_INTERVAL<<" accesses, average % of the cache in the recency "
+       <<"partition (target)"<<endl;
+
+    for(COUNTER k=0; k<arcRecords; k++) 
+    {
+        out<<"\t  "<<(k + 1) * CRC_ARC_INTERVAL<<": "<<100.0 * arcTrace[ 2 * k ]<<"% ("
+           <<100.0 * arcTrace[ 2 * k + 1 ]<<"%)"<<endl;
+    }
+
+    if( arcIntervalAccesses ) 
+    {
+        out<<"\t  last "<<arcIntervalAccesses<<": "<<100.0 * arcIntervalRecent / arcIntervalAccesses<<"% ("
+           <<100.0 * arcIntervalTarget / arcIntervalAccesses<<"%)"<<endl;
+    }
+
+    out<<endl;
+
+    return out;
+}
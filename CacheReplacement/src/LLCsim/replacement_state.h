@@ -17,74 +17,484 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 #include "utils.h"
 #include "crc_cache_defs.h"
+#include "crc_tag_match.h"
+#include "crc_set_dueling.h"
+#include "crc_instrument.h"
 
 // Replacement Policies Supported
 typedef enum 
 {
     CRC_REPL_LRU        = 0,
     CRC_REPL_RANDOM     = 1,
-    CRC_REPL_CONTESTANT = 2
+    CRC_REPL_CONTESTANT = 2,
+    CRC_REPL_SHIP       = 3,
+    CRC_REPL_HAWKEYE    = 4,
+    CRC_REPL_OPT        = 5,
+    CRC_REPL_OPT_BYPASS = 6,
+    CRC_REPL_TREE_PLRU  = 7,
+    CRC_REPL_NRU        = 8,
+    CRC_REPL_EAF        = 9,
+    CRC_REPL_SDBP       = 10,
+    CRC_REPL_SDBP_BYPASS = 11,
+    CRC_REPL_PERCEPTRON = 12,
+    CRC_REPL_ARC        = 13
 } ReplacemntPolicy;
 
-// Replacement State Per Cache Line
-typedef struct
+// Number of policies: valid policy numbers are 0 .. CRC_REPL_POLICIES - 1
+#define CRC_REPL_POLICIES   (CRC_REPL_ARC + 1)
+
+// The replacement state is kept per policy in flat arrays sized for that
+// policy only; there is no per-line record common to all policies.
+
+// RRIP keeps a 2-bit RRPV per line, CRC_RRPV_PER_WORD ways to a 32-bit word;
+// a set takes (assoc + 15) / 16 consecutive words
+#define CRC_RRPV_BITS       2
+#define CRC_RRPV_PER_WORD   16
+#define CRC_RRPV_LOW_BITS   0x55555555
+
+// True LRU keeps the recency order of a set of up to this many ways packed
+// in one 64-bit word, 4 bits per way; wider sets keep one byte per way
+#define CRC_LRU_PACKED_WAYS 16
+
+// Tree-PLRU and NRU keep the bits of a set in one field of a 64-bit word:
+// a binary tree over assoc rounded up to a power of two leaves (one bit per
+// inner node) for tree-PLRU, one bit per way for NRU. Fields are that many
+// bits rounded up to a power of two, so that no set straddles two words.
+#define CRC_RECENCY_MAX_WAYS 64
+
+// SHiP-PC: the Signature History Counter Table has 2^shctBits 3-bit
+// counters, indexed by the low bits of a signatureBits-wide hash of the PC
+#define CRC_SHIP_SHCT_BITS          14
+#define CRC_SHIP_SIGNATURE_BITS     14
+#define CRC_SHIP_MAX_BITS           16
+#define CRC_SHIP_SHCT_MAX           7
+#define CRC_SHIP_SHCT_USED          0x80    // entry looked up at least once
+
+// SHiP per-line flags
+#define CRC_SHIP_VALID              0x1     // the way has been filled
+#define CRC_SHIP_REUSED             0x2     // hit since it was inserted
+#define CRC_SHIP_DISTANT            0x4     // inserted predicted dead
+
+// Hawkeye: OPTgen runs on up to CRC_HAWKEYE_SAMPLED_SETS sets, each with a
+// history (and occupancy vector) of CRC_HAWKEYE_HISTORY x assoc accesses;
+// the predictor has 2^CRC_HAWKEYE_PREDICTOR_BITS 3-bit counters, and a
+// counter at or above CRC_HAWKEYE_FRIENDLY marks its PC cache-friendly.
+// A cache-friendly line holds its recency rank in the set (0 for the most
+// recent), an averse one CRC_HAWKEYE_RRPV_MAX.
+#define CRC_HAWKEYE_SAMPLED_SETS    64
+#define CRC_HAWKEYE_HISTORY         8
+#define CRC_HAWKEYE_PREDICTOR_BITS  11
+#define CRC_HAWKEYE_COUNTER_MAX     7
+#define CRC_HAWKEYE_FRIENDLY        4
+#define CRC_HAWKEYE_RRPV_MAX        255
+#define CRC_HAWKEYE_NO_TAG          (~(Addr_t)0)
+
+// EAF: the Bloom filter of evicted line addresses has CRC_EAF_BITS_PER_LINE
+// bits per cache line (rounded up to a power of two) and CRC_EAF_HASHES hash
+// functions, and is cleared after as many insertions as the cache has lines
+#define CRC_EAF_BITS_PER_LINE   8
+#define CRC_EAF_HASHES          3
+
+// SDBP: the sampler has LRU sets of partial tags (CRC_SDBP_TAG_BITS), as
+// many ways as the cache, for up to CRC_SDBP_SAMPLER_SETS of its sets; the
+// predictor has CRC_SDBP_TABLES tables of 2^CRC_SDBP_TABLE_BITS 2-bit
+// counters, each indexed by its own hash of a CRC_SDBP_SIGNATURE_BITS-bit PC
+// signature, and calls a line dead when its counters add up to at least
+// CRC_SDBP_THRESHOLD
+#define CRC_SDBP_SAMPLER_SETS       32
+#define CRC_SDBP_TAG_BITS           15
+#define CRC_SDBP_SIGNATURE_BITS     15
+#define CRC_SDBP_TABLES             3
+#define CRC_SDBP_TABLE_BITS         12
+#define CRC_SDBP_COUNTER_MAX        3
+#define CRC_SDBP_THRESHOLD          8
+
+// Perceptron: one table of 2^CRC_MPP_TABLE_BITS weights per feature, each
+// weight in CRC_MPP_WEIGHT_MIN..CRC_MPP_WEIGHT_MAX. A line whose weights add
+// up to at least CRC_MPP_DEAD is predicted dead, below CRC_MPP_LIVE to be
+// reused soon. Training on a sampler of up to CRC_MPP_SAMPLER_SETS sets
+// stops once a correct sum is CRC_MPP_TRAIN away from CRC_MPP_DEAD.
+#define CRC_MPP_TABLE_BITS      10
+#define CRC_MPP_WEIGHT_MIN      (-32)
+#define CRC_MPP_WEIGHT_MAX      31
+#define CRC_MPP_DEAD            32
+#define CRC_MPP_LIVE            (-32)
+#define CRC_MPP_TRAIN           40
+#define CRC_MPP_SAMPLER_SETS    64
+#define CRC_MPP_TAG_BITS        15
+#define CRC_MPP_HISTORY         3       // earlier PCs of the thread
+#define CRC_MPP_PAGE_BITS       12      // 4 KB pages
+
+// The perceptron features, in table order
+typedef enum
 {
-    UINT32  LRUstackposition;
+    CRC_MPP_PC          = 0,
+    CRC_MPP_PC_HISTORY  = 1,
+    CRC_MPP_PAGE        = 2,
+    CRC_MPP_OFFSET      = 3,
+    CRC_MPP_ACCESS_TYPE = 4,
+    CRC_MPP_THREAD      = 5,
+    CRC_MPP_FEATURES    = 6
+} MppFeature;
 
-    // CONTESTANTS: Add extra state per cache line here
+// ARC: each set remembers as many evicted lines as it has ways, by a ghost
+// entry of CRC_ARC_GHOST_TAG_BITS of tag, a list bit (evicted from the
+// frequency partition) and a valid bit. With the recency order, a frequency
+// bit per line and the target and ghost ring head per set, the state must
+// stay within CRC_ARC_BUDGET_BITS per line. The partition split is averaged
+// over every CRC_ARC_INTERVAL accesses.
+#define CRC_ARC_GHOST_TAG_BITS  14
+#define CRC_ARC_GHOST_FREQUENT  0x4000
+#define CRC_ARC_GHOST_VALID     0x8000
+#define CRC_ARC_BUDGET_BITS     32
+#define CRC_ARC_INTERVAL        (1 << 20)
 
-    UINT32 RRPV;
+// Instrumentation: how the insertion and eviction position histograms
+// measure a line, by the state the policy keeps; hits before eviction
+// saturate at the last bin
+#define CRC_INST_POSITION_NONE      0
+#define CRC_INST_POSITION_RRPV      1
+#define CRC_INST_POSITION_HAWKEYE   2
+#define CRC_INST_POSITION_STACK     3
+#define CRC_INST_HIT_BINS           16
 
-} LINE_REPLACEMENT_STATE;
+// The policies DRRIP duels, in CRC_SET_DUELING order
+typedef enum
+{
+    CRC_DRRIP_SRRIP = 0,
+    CRC_DRRIP_BRRIP = 1
+} DrripPolicy;
 
+// DRRIP set dueling defaults: leader sets per policy and thread, and the
+// width of the selector
+#define CRC_DRRIP_LEADERS       32
+#define CRC_DRRIP_COUNTER_BITS  10
+
+// The PC-indexed predictor of a policy, shared by all its sets: size
+// one-byte saturating counters in min..max, signed or not. The bits in
+// flags are not part of the counter (SHiP's CRC_SHIP_SHCT_USED).
+typedef struct
+{
+    unsigned char *entries;
+    size_t         size;
+    bool           isSigned;
+    int            min;
+    int            max;
+    unsigned char  flags;
+} CRC_PREDICTOR_TABLE;
 
 // The implementation for the cache replacement policy
 class CACHE_REPLACEMENT_STATE
 {
+    // compile-time policy hooks (below) call the helpers directly
+    friend class CRC_POLICY_LRU;
+    friend class CRC_POLICY_RANDOM;
+    friend class CRC_POLICY_DRRIP;
+    friend class CRC_POLICY_SHIP;
+    friend class CRC_POLICY_HAWKEYE;
+    friend class CRC_POLICY_OPT;
+    friend class CRC_POLICY_TREE_PLRU;
+    friend class CRC_POLICY_NRU;
+    friend class CRC_POLICY_EAF;
+    friend class CRC_POLICY_SDBP;
+    friend class CRC_POLICY_PERCEPTRON;
+    friend class CRC_POLICY_ARC;
 
   private:
     UINT32 numsets;
     UINT32 assoc;
     UINT32 replPolicy;
+    UINT32 numThreads;
+    UINT32 lineShift;
+
+    // Interleave: the numsets sets held here are sets shardIndex,
+    // shardIndex + shardCount, ... of a cache of globalSets sets
+    // (CRC_PARALLEL_CACHE); leader and sampled sets are placed by the
+    // global index
+    UINT32 globalSets;
+    UINT32 shardCount;
+    UINT32 shardIndex;
     
-    LINE_REPLACEMENT_STATE   **repl;
+    // RRPVs of every set: way w of set s is field w % CRC_RRPV_PER_WORD of
+    // rrpv[s * rrpvWords + w / CRC_RRPV_PER_WORD]. rrpvLastMask holds the
+    // low bit of each field of the last word of a set that names a way.
+    UINT32                   *rrpv;
+    UINT32                    rrpvWords;
+    UINT32                    rrpvLastMask;
+
+    // True LRU recency order of every set, most recently used way first:
+    // nibble i of lruOrder[set] (assoc <= CRC_LRU_PACKED_WAYS), else byte
+    // i of lruBytes[set*assoc], is the way at stack position i
+    unsigned long long       *lruOrder;
+    unsigned char            *lruBytes;
+
+    // Tree-PLRU and NRU bits of every set: set s is field s % 2^recencyFields
+    // of recencyBits[s >> recencyFields], 2^recencyWidth bits wide
+    unsigned long long       *recencyBits;
+    UINT32                    recencyFields;
+    UINT32                    recencyWidth;
+    unsigned long long        recencyMask;
+
+    // Tree-PLRU: node n of the tree (root 1, children 2n and 2n+1, leaves
+    // plruLeaves + way) is bit n-1. An access to a way rewrites the bits on
+    // its path (plruPath) to point away from it (plruSet).
+    UINT32                    plruLeaves;
+    UINT32                    plruLevels;
+    unsigned long long       *plruPath;
+    unsigned long long       *plruSet;
+
+    // NRU: the bits of every way of a set
+    unsigned long long        nruWays;
 
     COUNTER mytimer;  // tracks # of references to the cache
 
+    // Random number stream private to this instance, so that several caches
+    // can be simulated side by side (e.g. by parallel worker threads)
+    // without sharing the hidden state of rand()
+    struct random_data  rng;
+    char                rngState[ 128 ];
+
     // CONTESTANTS:  Add extra state for cache here
     bool hitpolicy;
     UINT32 RRIP_MAX;
     
-    UINT32 PS;
-    UINT32 PS_MAX;
     UINT32 EPSILON;
-    UINT32 LeaderSets;
-    UINT32 BL; // BRRIP Leader
-    UINT32 SL; // SRRIP Leader
-    UINT32 BI; // BRRIP Insert
-    UINT32 SI; // SRRIP Insert
+
+    // TA-DRRIP: SRRIP against BRRIP per thread, with its configuration
+    CRC_SET_DUELING *duel;
+    UINT32           duelLeaders;
+    UINT32           duelCounterBits;
+    COUNTER          duelTraceInterval;
+
+    // PC signature of the last access to each line (SHiP, Hawkeye), line
+    // setIndex*assoc+way
+    unsigned short *lineSignature;
+
+    // SHiP: CRC_SHIP_* flags of each line, and the SHCT with its
+    // CRC_SHIP_SHCT_USED bit
+    UINT32          shctBits;
+    UINT32          shipSignatureBits;
+    unsigned char  *shipFlags;
+    unsigned char  *shct;
+
+    COUNTER shipInserts[2];         // by prediction: intermediate, distant
+    COUNTER shipEvictions[2][2];    // by prediction, then by reuse
+
+    // Hawkeye: RRPV of each line, predictor, and per sampled set (set
+    // s is sampled when s % hawkStride == 0) its access count and the last
+    // hawkWindow accesses, access t in slot t % hawkWindow: tag (NO_TAG
+    // once reused), access time t, PC signature and occupancy vector entry
+    unsigned char         *hawkRRPV;
+    unsigned char         *hawkPredictor;
+    UINT32                 hawkStride;
+    UINT32                 hawkSampled;
+    UINT32                 hawkWindow;
+    UINT32                *hawkTime;
+    Addr_t                *hawkTags;
+    UINT32                *hawkTimes;
+    unsigned short        *hawkSignatures;
+    unsigned char         *hawkOccupancy;
+    CRC_TAG_MATCH_FN       hawkMatch;
+
+    COUNTER hawkInserts[2];         // averse, friendly
+    COUNTER hawkDetrains;           // friendly lines evicted
+    COUNTER hawkDecisions[2];       // OPTgen verdicts: miss, hit
+    COUNTER hawkAgree[2];           // ... that the predictor got right
+
+    // OPT: next-use index of the trace (see crc_next_use.h), and the entry
+    // of the last access to each line
+    const unsigned long long *optNextUse;
+    COUNTER                   optRecords;
+    unsigned long long       *optLineNext;
+    COUNTER                   optBypasses;
+
+    // EAF: the filter, 2^eafBits bits, and the insertions since it was
+    // last cleared
+    unsigned long long       *eafFilter;
+    UINT32                    eafBits;
+    COUNTER                   eafInserts;
+
+    COUNTER eafFills[2];            // not in the filter (bimodal), in it
+    COUNTER eafClears;
+
+    // SDBP: per set, the ways predicted dead at their fill (base
+    // policy: the LRU order above); the predictor tables, one after the
+    // other; and per sampler entry (sampled set s % sdbpStride == 0, entry
+    // (s / sdbpStride) * assoc + way) its partial tag, the signature of its
+    // last access and its LRU stack position, or assoc while invalid
+    unsigned long long       *sdbpDead;
+    unsigned char            *sdbpTables;
+    UINT32                    sdbpStride;
+    UINT32                    sdbpSampled;
+    unsigned short           *sdbpTags;
+    unsigned short           *sdbpSignatures;
+    unsigned char            *sdbpPosition;
+
+    COUNTER sdbpFills[2];           // predicted live, dead
+    COUNTER sdbpEvictions[2];       // by prediction: dead blocks missed, found
+    COUNTER sdbpFalseDead;          // hits on lines predicted dead
+    COUNTER sdbpBypasses;
+
+    // Perceptron: the weight tables, one after the other; the last
+    // CRC_MPP_HISTORY PCs of each thread, latest first; and per sampler
+    // entry (as for SDBP, mppStride) its partial tag, the weight indices
+    // of its last access and its LRU stack position, or assoc while invalid
+    signed char              *mppWeights;
+    Addr_t                   *mppHistory;
+    UINT32                    mppStride;
+    UINT32                    mppSampled;
+    unsigned short           *mppTags;
+    unsigned short           *mppIndices;
+    unsigned char            *mppPosition;
+
+    COUNTER mppInserts[3];                  // at RRPV 0, intermediate, distant
+    COUNTER mppTrainings;                   // sampler outcomes
+    COUNTER mppCorrect;                     // ... predicted right
+    COUNTER mppUpdates;                     // ... that moved the weights
+    COUNTER mppHelps[ CRC_MPP_FEATURES ];   // right only with the feature
+    COUNTER mppHurts[ CRC_MPP_FEATURES ];   // right only without it
+
+    // ARC: per set, the ways in the frequency partition (the others are in
+    // the recency partition; one recency order covers both, above), the
+    // target size of the recency partition, and a ring of ghost entries
+    // with the slot to write next
+    unsigned long long       *arcFrequent;
+    unsigned char            *arcTarget;
+    unsigned short           *arcGhosts;
+    unsigned char            *arcGhostHead;
+
+    COUNTER arcLines;                       // lines in the cache
+    COUNTER arcFrequentLines;               // ... in frequency partitions
+    COUNTER arcTargetSum;                   // recency targets of all sets
+    COUNTER arcGhostHits[2];                // recency ghosts, frequency ghosts
+    COUNTER arcEvictions[2];                // from recency, from frequency
+
+    // per-interval split: sums over the accesses of the interval, and the
+    // averages of every interval past (recency share, target share)
+    COUNTER arcIntervalAccesses;
+    double  arcIntervalRecent;
+    double  arcIntervalTarget;
+    COUNTER arcRecords;
+    COUNTER arcCapacity;
+    double *arcTrace;
+
+    // Instrumentation (crc_instrument.h), or NULL: the probes and, per line,
+    // the hits since its fill
+    CRC_INSTRUMENTATION      *instrument;
+    unsigned char            *instLineHits;
+    UINT32                    instPosition;
+
+    UINT32 instAccesses;
+    UINT32 instMisses;
+    UINT32 instBypasses;
+    UINT32 instEvictions;
+    UINT32 instInsertion;                   // position histograms
+    UINT32 instEviction;
+    UINT32 instHits;                        // hits before eviction
+    UINT32 instPsel;                        // first of one gauge per thread
+    UINT32 instArcTarget;
   public:
 
     // The constructor CAN NOT be changed
     CACHE_REPLACEMENT_STATE( UINT32 _sets, UINT32 _assoc, UINT32 _pol );
+    ~CACHE_REPLACEMENT_STATE();
 
     INT32  GetVictimInSet( UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc, Addr_t PC, Addr_t paddr, UINT32 accessType );
     void   UpdateReplacementState( UINT32 setIndex, INT32 updateWayID );
 
-    void   SetReplacementPolicy( UINT32 _pol ) { replPolicy = _pol; } 
+    void   SetReplacementPolicy( UINT32 _pol );
+    bool   InspectsLineState();
+    bool   IsLeaderSet( UINT32 setIndex );
     void   IncrementTimer() { mytimer++; } 
 
+    // Pull the replacement state of a set towards the core ahead of its use
+    void   PrefetchSet( UINT32 setIndex ) const
+    {
+        if( replPolicy == CRC_REPL_LRU ) 
+        {
+            __builtin_prefetch( lruOrder ? (const void *)&lruOrder[ setIndex ] : (const void *)&lruBytes[ setIndex * assoc ], 1, 3 );
+            return;
+        }
+
+        if( recencyBits ) 
+        {
+            __builtin_prefetch( &recencyBits[ setIndex >> recencyFields ], 1, 3 );
+            return;
+        }
+
+        if( rrpv ) 
+        {
+            __builtin_prefetch( &rrpv[ (size_t)setIndex * rrpvWords ], 1, 3 );
+        }
+    }
+
     void   UpdateReplacementState( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, 
                                    UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit );
 
     ostream&   PrintStats( ostream &out);
 
+    // Bytes of replacement state allocated for the whole cache
+    size_t     MetadataBytes();
+
+    // Line size of the cache, for the address features of the perceptron;
+    // only before the first access
+    void   SetLineSize( UINT32 _linesize );
+
+    // Threads sharing the cache; each gets its own DRRIP leader sets and
+    // policy selector. Only before the first access.
+    void   SetNumThreads( UINT32 _threads );
+    UINT32 NumThreads() { return numThreads; }
+
+    // Hold only set shard, shard + shards, ... of a cache of _globalSets
+    // sets, set s here being global set s * shards + shard; only before the
+    // first access
+    void   SetInterleave( UINT32 _globalSets, UINT32 _shards, UINT32 _shard );
+    UINT32 GlobalSet( UINT32 setIndex ) { return setIndex * shardCount + shardIndex; }
+
+    // Global (not per set) policy state: the set dueling of DRRIP, or NULL.
+    // Exposed so that a cache split over several instances can keep the
+    // selectors in step.
+    CRC_SET_DUELING *Dueling() { return duel; }
+
+    // The other global state: the predictor of SHiP (SHCT), Hawkeye, SDBP
+    // (all its tables) or the perceptron (all its weights); size 0 for the
+    // other policies
+    CRC_PREDICTOR_TABLE Predictor();
+
+    // DRRIP leader sets per policy and thread, selector width, and winner
+    // trace interval in fills (0: none); only before the first access
+    void   ConfigureDueling( UINT32 _leaders, UINT32 _counterBits, COUNTER _traceInterval );
+
+    // SHiP table sizes: 2^shctBits SHCT entries, signatureBits-wide PC
+    // signatures (up to CRC_SHIP_MAX_BITS); only before the first access
+    void   ConfigureSHiP( UINT32 _shctBits, UINT32 _signatureBits );
+
+    // The next-use index the OPT policies read, entry i for the i-th access
+    // to this cache; it must cover every access and outlive the simulation
+    void   SetNextUse( const unsigned long long *entries, COUNTER records );
+
+    // Sample the probes of the policy every interval accesses (see
+    // crc_instrument.h). The probes only exist in builds with
+    // CRC_INSTRUMENT; last, after the policy and its configuration, and
+    // before the first access.
+    void   EnableInstrumentation( COUNTER interval );
+    CRC_INSTRUMENTATION *Instrumentation();
+    bool   Instrumented() const { return instrument != NULL; }
+
+    // The probes, called by CRC_CACHE: the victim chosen in a full set (-1
+    // to bypass), then every simulated access with the way it hit or filled
+    void   InstrumentVictim( UINT32 setIndex, INT32 way );
+    void   InstrumentAccess( UINT32 setIndex, INT32 way, UINT32 accessType, bool hit );
+
   private:
     
     void   InitReplacementState();
+    void   FreeReplacementState();
+    UINT32 Random();
     INT32  Get_Random_Victim( UINT32 setIndex );
 
     INT32  Get_LRU_Victim( UINT32 setIndex );
@@ -92,11 +502,1255 @@ class CACHE_REPLACEMENT_STATE
 
     INT32 Get_DRRIP_Victim(UINT32 setIndex);
 
+    UINT32 GetRRPV( UINT32 setIndex, INT32 way );
+    void   SetRRPV( UINT32 setIndex, INT32 way, UINT32 value );
+
     void UpdateSRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit);
     void UpdateBRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit);
-    void UpdateDRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit);
+    void UpdateDRRIP(UINT32 setIndex, INT32 updateWayID, UINT32 tid, bool cacheHit);
+    ostream & PrintDRRIPStats( ostream &out );
+
+    UINT32 PCSignature( Addr_t PC, UINT32 bits );
+    void   UpdateSHiP( UINT32 setIndex, INT32 updateWayID, Addr_t PC, bool cacheHit );
+    ostream & PrintSHiPStats( ostream &out );
+
+    bool   IsHawkeyeSampled( UINT32 setIndex ) { return (GlobalSet( setIndex ) % hawkStride) == 0; }
+    INT32  Get_Hawkeye_Victim( UINT32 setIndex );
+    void   UpdateHawkeye( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, Addr_t PC,
+                          UINT32 accessType, bool cacheHit );
+    void   HawkeyeOptgen( UINT32 setIndex, Addr_t tag, UINT32 signature );
+    void   HawkeyeTrain( UINT32 signature, bool optHit );
+    ostream & PrintHawkeyeStats( ostream &out );
+
+    unsigned long long OptNextUse();
+    INT32  Get_OPT_Victim( UINT32 setIndex );
+    void   UpdateOPT( UINT32 setIndex, INT32 updateWayID );
+
+    unsigned long long GetRecencyBits( UINT32 setIndex );
+    void   SetRecencyBits( UINT32 setIndex, unsigned long long bits );
+    INT32  Get_TreePLRU_Victim( UINT32 setIndex );
+    void   UpdateTreePLRU( UINT32 setIndex, INT32 updateWayID );
+    INT32  Get_NRU_Victim( UINT32 setIndex );
+    void   UpdateNRU( UINT32 setIndex, INT32 updateWayID );
+
+    UINT32 EafHash( Addr_t line, UINT32 i );
+    bool   EafContains( Addr_t line );
+    void   EafInsert( Addr_t line );
+    INT32  Get_EAF_Victim( UINT32 setIndex, const LINE_STATE *vicSet );
+    void   UpdateEAF( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, bool cacheHit );
+    ostream & PrintEAFStats( ostream &out );
+
+    bool   IsSdbpSampled( UINT32 setIndex ) { return (GlobalSet( setIndex ) % sdbpStride) == 0; }
+    UINT32 SdbpIndex( UINT32 signature, UINT32 table );
+    bool   SdbpPredictDead( UINT32 signature );
+    void   SdbpTrain( UINT32 signature, bool dead );
+    void   SdbpSample( UINT32 setIndex, Addr_t tag, UINT32 signature );
+    INT32  Get_SDBP_Victim( UINT32 setIndex, Addr_t PC, UINT32 accessType );
+    void   UpdateSDBP( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, Addr_t PC,
+                       UINT32 accessType, bool cacheHit );
+    ostream & PrintSDBPStats( ostream &out );
+
+    bool   IsMppSampled( UINT32 setIndex ) { return (GlobalSet( setIndex ) % mppStride) == 0; }
+    void   MppFeatures( UINT32 setIndex, const LINE_STATE *currLine, UINT32 tid, Addr_t PC, UINT32 accessType,
+                        unsigned short *indices );
+    INT32  MppSum( const unsigned short *indices );
+    void   MppSample( UINT32 setIndex, Addr_t tag, const unsigned short *indices );
+    void   MppTrain( const unsigned short *indices, bool dead );
+    void   UpdatePerceptron( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, UINT32 tid,
+                             Addr_t PC, UINT32 accessType, bool cacheHit );
+    ostream & PrintPerceptronStats( ostream &out );
+
+    unsigned short ArcGhostTag( Addr_t tag );
+    INT32  Get_ARC_Victim( UINT32 setIndex, const LINE_STATE *vicSet );
+    void   UpdateARC( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine, bool cacheHit );
+    void   ArcMiss( UINT32 setIndex, INT32 updateWayID, Addr_t tag );
+    void   ArcRecordInterval();
+    ostream & PrintARCStats( ostream &out );
+
+    UINT32 InstrumentPosition( UINT32 setIndex, INT32 way );
+    void   InstrumentGauges();
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Compile-time policy hooks.                                                 //
+//                                                                            //
+// CRC_CACHE instantiates its access path once per class below and picks the  //
+// instantiation for the -LLCrepl number when it is built (see                //
+// CRC_CACHE::SelectAccessPath), so the specialized paths call the victim     //
+// and update helpers of their policy directly, inlined, without testing      //
+// replPolicy on every access. CRC_POLICY_GENERIC goes through                //
+// GetVictimInSet and UpdateReplacementState and serves every policy that     //
+// has no specialization of its own.                                          //
+//                                                                            //
+// mayInspectLines: false when the policy is known not to read LINE_STATE,    //
+// so the cache never builds the views; true defers to InspectsLineState().   //
+// mayInspectSet: the same for the view of the whole set passed to Victim.    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class CRC_POLICY_GENERIC
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = true;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->GetVictimInSet( tid, setIndex, vicSet, assoc, PC, paddr, accessType );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateReplacementState( setIndex, updateWayID, currLine, tid, PC, accessType, cacheHit );
+    }
+};
+
+class CRC_POLICY_LRU
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_LRU_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateLRU( setIndex, updateWayID );
+    }
+};
+
+class CRC_POLICY_RANDOM
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_Random_Victim( setIndex );
+    }
+
+    // Random replacement requires no replacement state update
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+    }
+};
+
+class CRC_POLICY_DRRIP
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_DRRIP_Victim( setIndex );
+    }
 
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateDRRIP( setIndex, updateWayID, tid, cacheHit );
+    }
 };
 
+class CRC_POLICY_SHIP
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_DRRIP_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateSHiP( setIndex, updateWayID, PC, cacheHit );
+    }
+};
+
+// Hawkeye follows the tag of the line it updates, so it reads currLine (but
+// not the set at victim selection)
+class CRC_POLICY_HAWKEYE
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_Hawkeye_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateHawkeye( setIndex, updateWayID, currLine, PC, accessType, cacheHit );
+    }
+};
+
+// Both OPT variants; Get_OPT_Victim tells them apart on a miss
+class CRC_POLICY_OPT
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_OPT_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateOPT( setIndex, updateWayID );
+    }
+};
+
+class CRC_POLICY_TREE_PLRU
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_TreePLRU_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateTreePLRU( setIndex, updateWayID );
+    }
+};
+
+class CRC_POLICY_NRU
+{
+  public:
+    static const bool mayInspectLines = false;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_NRU_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateNRU( setIndex, updateWayID );
+    }
+};
+
+// EAF reads the tag of the victim from the set and that of the incoming
+// line from currLine
+class CRC_POLICY_EAF
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = true;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_EAF_Victim( setIndex, vicSet );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateEAF( setIndex, updateWayID, currLine, cacheHit );
+    }
+};
+
+// Both SDBP variants; the sampler follows the tag of the line updated
+class CRC_POLICY_SDBP
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_SDBP_Victim( setIndex, PC, accessType );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateSDBP( setIndex, updateWayID, currLine, PC, accessType, cacheHit );
+    }
+};
+
+// The perceptron reads the address of the line updated from currLine
+class CRC_POLICY_PERCEPTRON
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = false;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_DRRIP_Victim( setIndex );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdatePerceptron( setIndex, updateWayID, currLine, tid, PC, accessType, cacheHit );
+    }
+};
+
+// ARC keeps the tags of the lines it evicts, read from the set, and looks
+// up that of the incoming line in currLine
+class CRC_POLICY_ARC
+{
+  public:
+    static const bool mayInspectLines = true;
+    static const bool mayInspectSet   = true;
+
+    static INT32 Victim( CACHE_REPLACEMENT_STATE *r, UINT32 tid, UINT32 setIndex, const LINE_STATE *vicSet, UINT32 assoc,
+                         Addr_t PC, Addr_t paddr, UINT32 accessType )
+    {
+        return r->Get_ARC_Victim( setIndex, vicSet );
+    }
+
+    static void Update( CACHE_REPLACEMENT_STATE *r, UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                        UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+    {
+        r->UpdateARC( setIndex, updateWayID, currLine, cacheHit );
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//////// HELPER FUNCTIONS FOR REPLACEMENT UPDATE AND VICTIM SELECTION //////////
+//                                                                            //
+// Defined here rather than in replacement_state.cpp so that the policy       //
+// hooks above inline them into the cache's access path.                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the LRU victim in the cache set by returning the       //
+// cache block at the bottom of the LRU stack. Top of LRU stack is '0'        //
+// while bottom of LRU stack is 'assoc-1'. The recency order is kept per      //
+// set, so this is a single read.                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_LRU_Victim( UINT32 setIndex )
+{
+    if( lruOrder ) 
+    {
+        return (lruOrder[ setIndex ] >> (4 * (assoc - 1))) & 0xf;
+    }
+
+    return lruBytes[ (size_t)setIndex * assoc + assoc - 1 ];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds a random victim in the cache set                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_Random_Victim( UINT32 setIndex )
+{
+    INT32 way = (Random() % assoc);
+    
+    return way;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function returns the next number of the instance's random stream      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::Random()
+{
+    int32_t r;
+
+    random_r( &rng, &r );
+
+    return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function finds the RRIP victim of a set: the first way whose RRPV is  //
+// RRIP_MAX-1 (3), after aging the whole set until one is. Rather than one    //
+// scan and one increment per aging step, it takes the maximum RRPV in one    //
+// pass, ages every way by the distance of that maximum to 3 in a second one, //
+// and returns the first way at 3. The victim and the aged RRPVs are the same //
+// as with the step-by-step search.                                           //
+//                                                                            //
+// The RRPVs are 2-bit fields, 16 to a word, so each pass works on a whole    //
+// word at once: the maximum is the OR of the high bits, then the OR of the   //
+// low bits of the fields whose high bit matches it; aging adds the same      //
+// amount to every field, which cannot carry as no field passes 3; and the    //
+// ways at 3 are the fields with both bits set, the first one found with a    //
+// ctz. Fields of the last word past assoc stay out of all three through      //
+// lastMask.                                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CRC_RRIP_Victim( UINT32 *setWords, UINT32 numWords, UINT32 lastMask )
+{
+    UINT32 high = 0;
+    UINT32 low  = 0;
+
+    for(UINT32 w=0; w<numWords; w++) 
+    {
+        UINT32 fields = (w + 1 < numWords) ? CRC_RRPV_LOW_BITS : lastMask;
+        high |= (setWords[w] >> 1) & fields;
+    }
+
+    for(UINT32 w=0; w<numWords; w++) 
+    {
+        UINT32 fields = (w + 1 < numWords) ? CRC_RRPV_LOW_BITS : lastMask;
+        UINT32 top    = high ? (setWords[w] >> 1) : ~(setWords[w] >> 1);
+        low |= setWords[w] & top & fields;
+    }
+
+    UINT32 maxRRPV = (high ? 2 : 0) + (low ? 1 : 0);
+
+    if( maxRRPV < 3 ) 
+    {
+        for(UINT32 w=0; w<numWords; w++) 
+        {
+            UINT32 fields = (w + 1 < numWords) ? CRC_RRPV_LOW_BITS : lastMask;
+            setWords[w] += (3 - maxRRPV) * fields;
+        }
+    }
+
+    for(UINT32 w=0; w<numWords; w++) 
+    {
+        UINT32 fields = (w + 1 < numWords) ? CRC_RRPV_LOW_BITS : lastMask;
+        UINT32 atMax  = setWords[w] & (setWords[w] >> 1) & fields;
+
+        if( atMax ) return w * CRC_RRPV_PER_WORD + __builtin_ctz( atMax ) / CRC_RRPV_BITS;
+    }
+
+    return -1;
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::Get_DRRIP_Victim(UINT32 setIndex) {
+    return CRC_RRIP_Victim( &rrpv[ (size_t)setIndex * rrpvWords ], rrpvWords, rrpvLastMask );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Read and write the 2-bit RRPV of one way                                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::GetRRPV( UINT32 setIndex, INT32 way )
+{
+    UINT32 word = rrpv[ (size_t)setIndex * rrpvWords + way / CRC_RRPV_PER_WORD ];
+
+    return (word >> (CRC_RRPV_BITS * (way % CRC_RRPV_PER_WORD))) & 3;
+}
+
+inline void CACHE_REPLACEMENT_STATE::SetRRPV( UINT32 setIndex, INT32 way, UINT32 value )
+{
+    UINT32 &word  = rrpv[ (size_t)setIndex * rrpvWords + way / CRC_RRPV_PER_WORD ];
+    UINT32  shift = CRC_RRPV_BITS * (way % CRC_RRPV_PER_WORD);
+
+    word = (word & ~(3U << shift)) | (value << shift);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// This function implements the LRU update routine for the traditional        //
+// LRU replacement policy. The arguments to the function are the physical     //
+// way and set index.                                                         //
+//                                                                            //
+// The way moves to the top of the stack and the ways above its old position  //
+// move down by one. Packed: the position p of the way is the lowest nibble   //
+// of the order equal to it (found with a SWAR zero-nibble test), nibbles     //
+// 0..p-1 shift up by 4 bits and the way goes into nibble 0, all without      //
+// branches.                                                                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateLRU( UINT32 setIndex, INT32 updateWayID )
+{
+    const unsigned long long ones = 0x1111111111111111ULL;
+
+    if( lruOrder ) 
+    {
+        unsigned long long order = lruOrder[ setIndex ];
+
+        // nibbles of x are zero where order holds updateWayID
+        unsigned long long x     = order ^ (updateWayID * ones);
+        unsigned long long found = ~(x | (x >> 1) | (x >> 2) | (x >> 3)) & ones;
+
+        // the way is in the order, so found is never zero; positions at or
+        // beyond assoc are only ever above the real match
+        UINT32             shift = __builtin_ctzll( found );
+        unsigned long long above = (1ULL << shift) - 1;
+
+        lruOrder[ setIndex ] = (order & ~((above << 4) | 0xf)) | ((order & above) << 4) | updateWayID;
+        return;
+    }
+
+    unsigned char *order = &lruBytes[ (size_t)setIndex * assoc ];
+    unsigned char *pos   = (unsigned char *) memchr( order, updateWayID, assoc );
+
+    memmove( order + 1, order, pos - order );
+    order[0] = updateWayID;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateSRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit) {
+    if (cacheHit)
+        if(hitpolicy) {
+            UINT32 value = GetRRPV(setIndex, updateWayID);
+            if (value > 0)
+                SetRRPV(setIndex, updateWayID, value - 1);
+        }
+        else 
+            SetRRPV(setIndex, updateWayID, 0);
+    else
+        SetRRPV(setIndex, updateWayID, RRIP_MAX - 2);
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateBRRIP(UINT32 setIndex, INT32 updateWayID, bool cacheHit) {
+    if (cacheHit)
+        if (hitpolicy) {
+            UINT32 value = GetRRPV(setIndex, updateWayID);
+            if (value > 0) 
+                SetRRPV(setIndex, updateWayID, value - 1);
+        }
+        else 
+            SetRRPV(setIndex, updateWayID, 0);
+    else {
+        UINT32 randnum = Random() % EPSILON;
+        if (randnum == EPSILON - 1) 
+            SetRRPV(setIndex, updateWayID, RRIP_MAX - 2);
+        else 
+            SetRRPV(setIndex, updateWayID, RRIP_MAX - 1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Thread-aware DRRIP (Jaleel et al., PACT 2008). Every thread duels SRRIP    //
+// against BRRIP in its own leader sets with its own selector (see            //
+// crc_set_dueling.h). In a leader set of another thread, an access follows   //
+// its own thread's selector, so a streaming thread moves only its own        //
+// insertions to BRRIP. With one thread this is plain DRRIP.                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::UpdateDRRIP(UINT32 setIndex, INT32 updateWayID, UINT32 tid, bool cacheHit) {
+    assert( tid < numThreads );
+
+    UINT32 policy = duel->Policy(GlobalSet(setIndex), tid);
+
+    if (policy == CRC_DRRIP_SRRIP)
+        UpdateSRRIP(setIndex, updateWayID, cacheHit);
+    else
+        UpdateBRRIP(setIndex, updateWayID, cacheHit);
+
+    if (!cacheHit)
+        duel->Fill(GlobalSet(setIndex), tid, policy);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// SHiP-PC (Wu et al., MICRO 2011) on top of SRRIP. Each line remembers the   //
+// signature (hashed PC) that inserted it and whether it has been hit since.  //
+// A hit trains the signature's SHCT counter up; a line evicted without a     //
+// hit trains it down. A fill whose signature counter is 0 is predicted to    //
+// see no reuse and goes in at the distant RRPV, every other fill at the      //
+// intermediate one. Victims are chosen as in SRRIP.                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::PCSignature( Addr_t PC, UINT32 bits )
+{
+    // Fibonacci hash: the top bits mix every bit of the PC
+    return (UINT32)(((unsigned long long)PC * 0x9e3779b97f4a7c15ULL) >> (64 - bits));
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateSHiP( UINT32 setIndex, INT32 updateWayID, Addr_t PC, bool cacheHit )
+{
+    size_t         line     = (size_t)setIndex * assoc + updateWayID;
+    UINT32         shctMask = (1 << shctBits) - 1;
+    unsigned char &flags    = shipFlags[ line ];
+
+    if( cacheHit ) 
+    {
+        unsigned char &counter = shct[ lineSignature[ line ] & shctMask ];
+
+        if( (counter & CRC_SHIP_SHCT_MAX) < CRC_SHIP_SHCT_MAX ) counter++;
+
+        flags |= CRC_SHIP_REUSED;
+        SetRRPV( setIndex, updateWayID, 0 );
+        return;
+    }
+
+    // the line leaving this way trains its signature down if it was never hit
+    if( flags & CRC_SHIP_VALID ) 
+    {
+        bool distant = (flags & CRC_SHIP_DISTANT) != 0;
+        bool reused  = (flags & CRC_SHIP_REUSED) != 0;
+
+        if( !reused ) 
+        {
+            unsigned char &counter = shct[ lineSignature[ line ] & shctMask ];
+
+            if( counter & CRC_SHIP_SHCT_MAX ) counter--;
+        }
+
+        shipEvictions[ distant ][ reused ]++;
+    }
+
+    UINT32         signature = PCSignature( PC, shipSignatureBits );
+    unsigned char &counter   = shct[ signature & shctMask ];
+    bool           distant   = (counter & CRC_SHIP_SHCT_MAX) == 0;
+
+    counter |= CRC_SHIP_SHCT_USED;
+
+    lineSignature[ line ] = signature;
+    flags                 = CRC_SHIP_VALID | (distant ? CRC_SHIP_DISTANT : 0);
+    shipInserts[ distant ]++;
+
+    SetRRPV( setIndex, updateWayID, distant ? RRIP_MAX - 1 : RRIP_MAX - 2 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Hawkeye (Jain and Lin, ISCA 2016). OPTgen replays the accesses to the      //
+// sampled sets against an occupancy vector to tell whether Belady's OPT      //
+// would have hit, and trains a PC-indexed predictor with the verdict (see    //
+// HawkeyeOptgen in replacement_state.cpp). Lines the predictor calls cache-  //
+// averse go in at CRC_HAWKEYE_RRPV_MAX and are evicted first; cache-friendly //
+// ones go in at 0 and age the friendly lines that were more recent, so the   //
+// friendly lines keep distinct ranks in LRU order and never tie. A hit keeps //
+// the line friendly whatever its PC predicts: the reuse is already proven.   //
+// With no averse line left, the least recent friendly line goes, and in a    //
+// sampled set its PC is trained down. Writebacks are inserted averse and do  //
+// not train.                                                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_Hawkeye_Victim( UINT32 setIndex )
+{
+    const unsigned char *rrpvSet = &hawkRRPV[ (size_t)setIndex * assoc ];
+    INT32                victim  = 0;
+
+    for(UINT32 way=0; way<assoc; way++) 
+    {
+        if( rrpvSet[way] == CRC_HAWKEYE_RRPV_MAX ) return way;
+        if( rrpvSet[way] > rrpvSet[victim] ) victim = way;
+    }
+
+    // the least recent cache-friendly line: its PC was wrong to call it
+    // friendly. Like OPTgen, this only trains on the sampled sets.
+    if( IsHawkeyeSampled( setIndex ) ) 
+    {
+        unsigned char &counter = hawkPredictor[ lineSignature[ (size_t)setIndex * assoc + victim ] ];
+
+        if( counter > 0 ) counter--;
+        hawkDetrains++;
+    }
+
+    return victim;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateHawkeye( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                                                    Addr_t PC, UINT32 accessType, bool cacheHit )
+{
+    size_t         line      = (size_t)setIndex * assoc + updateWayID;
+    unsigned char *rrpvSet   = &hawkRRPV[ (size_t)setIndex * assoc ];
+    UINT32         signature = PCSignature( PC, CRC_HAWKEYE_PREDICTOR_BITS );
+    unsigned char  rank      = rrpvSet[ updateWayID ];
+    bool           friendly  = false;
+
+    lineSignature[ line ] = signature;
+
+    if( accessType != ACCESS_WRITEBACK ) 
+    {
+        if( IsHawkeyeSampled( setIndex ) ) HawkeyeOptgen( setIndex, currLine->tag, signature );
+
+        friendly = hawkPredictor[ signature ] >= CRC_HAWKEYE_FRIENDLY;
+
+        if( !cacheHit ) hawkInserts[ friendly ]++;
+
+        friendly = friendly || cacheHit;
+    }
+
+    // keep the friendly ranks 0, 1, 2...: the friendly lines more recent
+    // than this one age by one as it becomes the most recent, and the less
+    // recent ones close the gap it leaves when it turns averse
+    for(UINT32 way=0; way<assoc; way++) 
+    {
+        if( friendly ) 
+        {
+            if( rrpvSet[way] < rank ) rrpvSet[way]++;
+        }
+        else if( rank != CRC_HAWKEYE_RRPV_MAX && rrpvSet[way] > rank && rrpvSet[way] != CRC_HAWKEYE_RRPV_MAX ) 
+        {
+            rrpvSet[way]--;
+        }
+    }
+
+    rrpvSet[ updateWayID ] = friendly ? 0 : CRC_HAWKEYE_RRPV_MAX;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Belady's OPT: evict the line whose next use lies furthest in the future.   //
+// The cache counts its accesses in mytimer before consulting the policy, so  //
+// the current access is entry mytimer-1 of the next-use index. Entries are   //
+// 1 + position of the next use, 0 for never, so entry - 1 ranks lines with   //
+// "never" last. With bypass, an incoming line whose next use comes no        //
+// sooner than that of every line in the set is not cached at all.            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned long long CACHE_REPLACEMENT_STATE::OptNextUse()
+{
+    // the index must cover the whole simulation
+    assert( optNextUse && mytimer > 0 && mytimer <= optRecords );
+
+    return optNextUse[ mytimer - 1 ];
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::Get_OPT_Victim( UINT32 setIndex )
+{
+    const unsigned long long *next   = &optLineNext[ (size_t)setIndex * assoc ];
+    INT32                     victim = 0;
+
+    for(UINT32 way=1; way<assoc; way++) 
+    {
+        if( next[way] - 1 > next[victim] - 1 ) victim = way;
+    }
+
+    if( replPolicy == CRC_REPL_OPT_BYPASS && OptNextUse() - 1 >= next[victim] - 1 ) 
+    {
+        optBypasses++;
+        return -1;
+    }
+
+    return victim;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateOPT( UINT32 setIndex, INT32 updateWayID )
+{
+    optLineNext[ (size_t)setIndex * assoc + updateWayID ] = OptNextUse();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Read and write the tree-PLRU or NRU bits of one set                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned long long CACHE_REPLACEMENT_STATE::GetRecencyBits( UINT32 setIndex )
+{
+    UINT32 shift = (setIndex & ((1 << recencyFields) - 1)) << recencyWidth;
+
+    return (recencyBits[ setIndex >> recencyFields ] >> shift) & recencyMask;
+}
+
+inline void CACHE_REPLACEMENT_STATE::SetRecencyBits( UINT32 setIndex, unsigned long long bits )
+{
+    unsigned long long &word  = recencyBits[ setIndex >> recencyFields ];
+    UINT32              shift = (setIndex & ((1 << recencyFields) - 1)) << recencyWidth;
+
+    word = (word & ~(recencyMask << shift)) | (bits << shift);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Tree-PLRU. Every inner node of a binary tree over the ways points to the   //
+// half it was not last accessed through: bit clear for the left child, set   //
+// for the right. The victim is found by following the bits from the root,    //
+// one step per level with no branch on their values; an access points every  //
+// node on its path away from it with one mask and one OR.                    //
+//                                                                            //
+// With assoc not a power of two the tree is padded to one; a node whose      //
+// right child holds padding only is never in plruSet, so it always points    //
+// left and the victim is always a real way. The nodes that are neither       //
+// padding nor always left are assoc-1.                                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_TreePLRU_Victim( UINT32 setIndex )
+{
+    unsigned long long bits = GetRecencyBits( setIndex );
+    UINT32             node = 1;
+
+    for(UINT32 level=0; level<plruLevels; level++) 
+    {
+        node = 2 * node + ((bits >> (node - 1)) & 1);
+    }
+
+    return node - plruLeaves;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateTreePLRU( UINT32 setIndex, INT32 updateWayID )
+{
+    unsigned long long bits = GetRecencyBits( setIndex );
+
+    SetRecencyBits( setIndex, (bits & ~plruPath[ updateWayID ]) | plruSet[ updateWayID ] );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// NRU: one bit per way, set when the way is accessed. When that would set    //
+// the bits of every way, the others are cleared instead, so there is always  //
+// a way with a clear bit; the victim is the first of them.                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline INT32 CACHE_REPLACEMENT_STATE::Get_NRU_Victim( UINT32 setIndex )
+{
+    return __builtin_ctzll( ~GetRecencyBits( setIndex ) & nruWays );
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateNRU( UINT32 setIndex, INT32 updateWayID )
+{
+    unsigned long long way  = 1ULL << updateWayID;
+    unsigned long long bits = GetRecencyBits( setIndex ) | way;
+
+    SetRecencyBits( setIndex, (bits == nruWays) ? way : bits );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// EAF (Seshadri et al., PACT 2012) on top of SRRIP victim selection. The     //
+// address of every evicted line goes into a Bloom filter that holds about    //
+// as many addresses as the cache has lines. A missed line found there was    //
+// evicted too early, so it goes in at RRPV 0 like a hit; any other line is   //
+// inserted bimodally as in BRRIP, so a thrashing working set keeps only a    //
+// part of itself in the cache instead of evicting itself. The filter is      //
+// cleared once it has taken as many addresses as the cache holds lines.      //
+//                                                                            //
+// The hash functions are multiply-shift: the top eafBits bits of the line    //
+// address times an odd constant, one constant per function.                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::EafHash( Addr_t line, UINT32 i )
+{
+    static const unsigned long long multipliers[ CRC_EAF_HASHES ] = 
+    {
+        0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL
+    };
+
+    return (UINT32)(((unsigned long long)line * multipliers[i]) >> (64 - eafBits));
+}
+
+inline bool CACHE_REPLACEMENT_STATE::EafContains( Addr_t line )
+{
+    bool found = true;
+
+    for(UINT32 i=0; i<CRC_EAF_HASHES; i++) 
+    {
+        UINT32 bit = EafHash( line, i );
+
+        found &= (eafFilter[ bit >> 6 ] >> (bit & 63)) & 1;
+    }
+
+    return found;
+}
+
+inline void CACHE_REPLACEMENT_STATE::EafInsert( Addr_t line )
+{
+    for(UINT32 i=0; i<CRC_EAF_HASHES; i++) 
+    {
+        UINT32 bit = EafHash( line, i );
+
+        eafFilter[ bit >> 6 ] |= 1ULL << (bit & 63);
+    }
+
+    if( ++eafInserts == (COUNTER)numsets * assoc ) 
+    {
+        memset( eafFilter, 0, ((size_t)1 << eafBits) / 8 );
+        eafInserts = 0;
+        eafClears++;
+    }
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::Get_EAF_Victim( UINT32 setIndex, const LINE_STATE *vicSet )
+{
+    INT32 victim = Get_DRRIP_Victim( setIndex );
+
+    // the line address: the set count is a power of two
+    EafInsert( vicSet[ victim ].tag * globalSets + GlobalSet( setIndex ) );
+
+    return victim;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateEAF( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                                                bool cacheHit )
+{
+    if( cacheHit ) 
+    {
+        SetRRPV( setIndex, updateWayID, 0 );
+        return;
+    }
+
+    bool early = EafContains( currLine->tag * globalSets + GlobalSet( setIndex ) );
+
+    eafFills[ early ]++;
+
+    if( early || Random() % EPSILON == EPSILON - 1 ) 
+    {
+        SetRRPV( setIndex, updateWayID, early ? 0 : RRIP_MAX - 2 );
+        return;
+    }
+
+    SetRRPV( setIndex, updateWayID, RRIP_MAX - 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Sampling dead block prediction (Khan et al., MICRO 2010) on top of LRU. A  //
+// sampler of partial tags for a few sets remembers the signature of the PC   //
+// that last touched each of its lines: a line hit again trains that          //
+// signature live, a line that drops out of the sampler trains it dead (see   //
+// SdbpSample in replacement_state.cpp). The three skewed tables are indexed  //
+// by different hashes of the signature, so two signatures rarely share all   //
+// three counters.                                                            //
+//                                                                            //
+// A fill predicts whether the line is dead on arrival. The victim is the     //
+// dead line deepest in the LRU stack, and only the LRU line if none is dead; //
+// a dead line at the top of the stack is left one reuse window, until        //
+// another line of the set is touched, so that a line accessed twice in a     //
+// row still hits. A hit proves the prediction wrong and clears it. Hits are  //
+// not predicted again: a line of a thrashing PC that outlives the sampler's  //
+// LRU window because its neighbours were evicted dead would be predicted     //
+// dead by the same PC on its first hit and thrown out, undoing the           //
+// protection. With bypass, a miss predicted dead is not cached at all,       //
+// outside the sampled sets: the sampler learns from the accesses to those    //
+// sets, so they never bypass. Writebacks do not train and are inserted dead, //
+// but never bypassed.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::SdbpIndex( UINT32 signature, UINT32 table )
+{
+    static const UINT32 multipliers[ CRC_SDBP_TABLES ] = { 0x9e3779b1, 0x85ebca6b, 0xc2b2ae35 };
+
+    return (UINT32)((signature + 1) * multipliers[ table ]) >> (32 - CRC_SDBP_TABLE_BITS);
+}
+
+inline bool CACHE_REPLACEMENT_STATE::SdbpPredictDead( UINT32 signature )
+{
+    UINT32 sum = 0;
+
+    for(UINT32 t=0; t<CRC_SDBP_TABLES; t++) 
+    {
+        sum += sdbpTables[ (t << CRC_SDBP_TABLE_BITS) + SdbpIndex( signature, t ) ];
+    }
+
+    return sum >= CRC_SDBP_THRESHOLD;
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::Get_SDBP_Victim( UINT32 setIndex, Addr_t PC, UINT32 accessType )
+{
+    if( replPolicy == CRC_REPL_SDBP_BYPASS && accessType != ACCESS_WRITEBACK && !IsSdbpSampled( setIndex ) &&
+        SdbpPredictDead( PCSignature( PC, CRC_SDBP_SIGNATURE_BITS ) ) ) 
+    {
+        sdbpBypasses++;
+        return -1;
+    }
+
+    // the dead lines below the top of the stack, from the bottom up
+    unsigned long long dead = sdbpDead[ setIndex ];
+
+    for(UINT32 p=assoc-1; dead && p>0; p--) 
+    {
+        UINT32 way = lruOrder ? (UINT32)((lruOrder[ setIndex ] >> (4 * p)) & 0xf) : lruBytes[ (size_t)setIndex * assoc + p ];
+
+        if( (dead >> way) & 1 ) 
+        {
+            sdbpEvictions[1]++;
+            return way;
+        }
+    }
+
+    sdbpEvictions[0]++;
+
+    return Get_LRU_Victim( setIndex );
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateSDBP( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                                                 Addr_t PC, UINT32 accessType, bool cacheHit )
+{
+    unsigned long long way  = 1ULL << updateWayID;
+    bool               dead = true;
+
+    if( accessType != ACCESS_WRITEBACK ) 
+    {
+        UINT32 signature = PCSignature( PC, CRC_SDBP_SIGNATURE_BITS );
+
+        if( IsSdbpSampled( setIndex ) ) SdbpSample( setIndex, currLine->tag, signature );
+
+        if( !cacheHit ) dead = SdbpPredictDead( signature );
+    }
+
+    if( cacheHit ) 
+    {
+        sdbpFalseDead += (sdbpDead[ setIndex ] & way) != 0;
+        sdbpDead[ setIndex ] &= ~way;
+    }
+    else 
+    {
+        sdbpFills[ dead ]++;
+        sdbpDead[ setIndex ] = dead ? (sdbpDead[ setIndex ] | way) : (sdbpDead[ setIndex ] & ~way);
+    }
+
+    UpdateLRU( setIndex, updateWayID );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Multiperspective reuse prediction (after Jimenez and Teran, MICRO 2017)    //
+// on top of SRRIP victim selection. Every feature of an access (PC, the      //
+// earlier PCs of the thread, page, line offset within the page, access type  //
+// and thread) is hashed into its own table of small weights, and the sum of  //
+// the weights it selects predicts whether the line will be reused: at or     //
+// above CRC_MPP_DEAD it goes in at the distant RRPV and a hit leaves it      //
+// there, below CRC_MPP_LIVE it goes in at RRPV 0, otherwise at the           //
+// intermediate RRPV. The weights learn from a sampler of a few sets, as in   //
+// SDBP (see MppSample in replacement_state.cpp). Writebacks go in distant    //
+// and do not train.                                                          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline void CACHE_REPLACEMENT_STATE::MppFeatures( UINT32 setIndex, const LINE_STATE *currLine, UINT32 tid,
+                                                  Addr_t PC, UINT32 accessType, unsigned short *indices )
+{
+    static const unsigned long long multipliers[ CRC_MPP_FEATURES ] = 
+    {
+        0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL,
+        0xd6e8feb86659fd93ULL, 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL
+    };
+
+    const Addr_t      *history = &mppHistory[ tid * CRC_MPP_HISTORY ];
+    unsigned long long line    = currLine->tag * globalSets + GlobalSet( setIndex );
+    unsigned long long value[ CRC_MPP_FEATURES ];
+
+    value[ CRC_MPP_PC ]          = PC;
+    value[ CRC_MPP_PC_HISTORY ]  = history[0] ^ (history[1] << 7) ^ (history[2] << 14);
+    value[ CRC_MPP_PAGE ]        = line >> (CRC_MPP_PAGE_BITS - lineShift);
+    value[ CRC_MPP_OFFSET ]      = line & ((1 << (CRC_MPP_PAGE_BITS - lineShift)) - 1);
+    value[ CRC_MPP_ACCESS_TYPE ] = accessType;
+    value[ CRC_MPP_THREAD ]      = tid;
+
+    for(UINT32 f=0; f<CRC_MPP_FEATURES; f++) 
+    {
+        UINT32 hash = (UINT32)(((value[f] + 1) * multipliers[f]) >> (64 - CRC_MPP_TABLE_BITS));
+
+        indices[f] = (f << CRC_MPP_TABLE_BITS) + hash;
+    }
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::MppSum( const unsigned short *indices )
+{
+    INT32 sum = 0;
+
+    for(UINT32 f=0; f<CRC_MPP_FEATURES; f++) sum += mppWeights[ indices[f] ];
+
+    return sum;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdatePerceptron( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                                                       UINT32 tid, Addr_t PC, UINT32 accessType, bool cacheHit )
+{
+    if( accessType == ACCESS_WRITEBACK ) 
+    {
+        SetRRPV( setIndex, updateWayID, RRIP_MAX - 1 );
+        return;
+    }
+
+    assert( tid < numThreads );
+
+    unsigned short indices[ CRC_MPP_FEATURES ];
+
+    MppFeatures( setIndex, currLine, tid, PC, accessType, indices );
+
+    Addr_t *history = &mppHistory[ tid * CRC_MPP_HISTORY ];
+
+    memmove( history + 1, history, (CRC_MPP_HISTORY - 1) * sizeof(Addr_t) );
+    history[0] = PC;
+
+    if( IsMppSampled( setIndex ) ) MppSample( setIndex, currLine->tag, indices );
+
+    INT32 sum = MppSum( indices );
+
+    if( cacheHit ) 
+    {
+        if( sum < CRC_MPP_DEAD ) SetRRPV( setIndex, updateWayID, 0 );
+        return;
+    }
+
+    UINT32 rrpv = (sum >= CRC_MPP_DEAD) ? RRIP_MAX - 1 : ((sum < CRC_MPP_LIVE) ? 0 : RRIP_MAX - 2);
+
+    mppInserts[ (rrpv == 0) ? 0 : rrpv - 1 ]++;
+    SetRRPV( setIndex, updateWayID, rrpv );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// ARC (Megiddo and Modha, FAST 2003) within each set, with the replacement   //
+// rule of CAR. A line filled on a miss joins the recency partition; a hit    //
+// moves it to the frequency partition. The victim is the least recently      //
+// used line of the recency partition while that partition holds at least     //
+// the set's target (and one line), else that of the frequency partition.     //
+// Evicted lines leave a ghost entry in the set's ring; a miss that finds     //
+// its ghost moves the target towards the partition it was evicted from (by   //
+// the ratio of the two ghost counts, at least 1), and the line rejoins the   //
+// frequency partition. The target adapts on the miss, after its victim was   //
+// chosen. See ArcMiss in replacement_state.cpp.                              //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline unsigned short CACHE_REPLACEMENT_STATE::ArcGhostTag( Addr_t tag )
+{
+    unsigned short partial = (unsigned short)((tag ^ (tag >> CRC_ARC_GHOST_TAG_BITS)) & ((1 << CRC_ARC_GHOST_TAG_BITS) - 1));
+
+    return CRC_ARC_GHOST_VALID | partial;
+}
+
+inline INT32 CACHE_REPLACEMENT_STATE::Get_ARC_Victim( UINT32 setIndex, const LINE_STATE *vicSet )
+{
+    unsigned long long frequent = arcFrequent[ setIndex ];
+    UINT32             recent   = assoc - __builtin_popcountll( frequent );
+    UINT32             target   = arcTarget[ setIndex ] ? arcTarget[ setIndex ] : 1;
+    bool               fromT2   = recent < target && frequent;
+    INT32              victim   = -1;
+
+    // the bottom-most way of the chosen partition in the recency order
+    for(INT32 pos=assoc - 1; victim == -1; pos--) 
+    {
+        INT32 way = lruOrder ? (INT32)((lruOrder[ setIndex ] >> (4 * pos)) & 0xf) : lruBytes[ (size_t)setIndex * assoc + pos ];
+
+        if( (((frequent >> way) & 1) != 0) == fromT2 ) victim = way;
+    }
+
+    unsigned short ghost = ArcGhostTag( vicSet[ victim ].tag ) | (fromT2 ? CRC_ARC_GHOST_FREQUENT : 0);
+    unsigned char &head  = arcGhostHead[ setIndex ];
+
+    arcGhosts[ (size_t)setIndex * assoc + head ] = ghost;
+    head = ((UINT32)head + 1 == assoc) ? 0 : head + 1;
+
+    arcEvictions[ fromT2 ]++;
+    arcFrequentLines -= fromT2;
+    arcLines--;
+
+    return victim;
+}
+
+inline void CACHE_REPLACEMENT_STATE::UpdateARC( UINT32 setIndex, INT32 updateWayID, const LINE_STATE *currLine,
+                                                bool cacheHit )
+{
+    unsigned long long way = 1ULL << updateWayID;
+
+    if( cacheHit ) 
+    {
+        arcFrequentLines += !(arcFrequent[ setIndex ] & way);
+        arcFrequent[ setIndex ] |= way;
+    }
+    else 
+    {
+        ArcMiss( setIndex, updateWayID, currLine->tag );
+    }
+
+    UpdateLRU( setIndex, updateWayID );
+
+    arcIntervalRecent += (double)(arcLines - arcFrequentLines) / ((double)numsets * assoc);
+    arcIntervalTarget += (double)arcTargetSum / ((double)numsets * assoc);
+
+    if( ++arcIntervalAccesses == CRC_ARC_INTERVAL ) ArcRecordInterval();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Instrumentation probes. The position of a line is its RRPV, or its place   //
+// in the recency stack (0: most recently used) for the policies that keep    //
+// one. A bypass counts in place of an eviction; writebacks do not count as   //
+// hits of a line.                                                            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+inline UINT32 CACHE_REPLACEMENT_STATE::InstrumentPosition( UINT32 setIndex, INT32 way )
+{
+    if( instPosition == CRC_INST_POSITION_RRPV ) return GetRRPV( setIndex, way );
+    if( instPosition == CRC_INST_POSITION_HAWKEYE ) return hawkRRPV[ (size_t)setIndex * assoc + way ];
+
+    if( lruOrder ) 
+    {
+        // the lowest nibble equal to way: a borrow can only flag nibbles
+        // above the first match
+        unsigned long long x    = lruOrder[ setIndex ] ^ (0x1111111111111111ULL * way);
+        unsigned long long zero = (x - 0x1111111111111111ULL) & ~x & 0x8888888888888888ULL;
+
+        return __builtin_ctzll( zero ) / 4;
+    }
+
+    const unsigned char *order = &lruBytes[ (size_t)setIndex * assoc ];
+
+    return (UINT32)((const unsigned char *)memchr( order, way, assoc ) - order);
+}
+
+inline void CACHE_REPLACEMENT_STATE::InstrumentVictim( UINT32 setIndex, INT32 way )
+{
+    if( way == -1 ) 
+    {
+        instrument->Count( instBypasses );
+        return;
+    }
+
+    instrument->Count( instEvictions );
+    instrument->Record( instHits, instLineHits[ (size_t)setIndex * assoc + way ] );
+
+    if( instPosition != CRC_INST_POSITION_NONE ) instrument->Record( instEviction, InstrumentPosition( setIndex, way ) );
+}
+
+inline void CACHE_REPLACEMENT_STATE::InstrumentAccess( UINT32 setIndex, INT32 way, UINT32 accessType, bool hit )
+{
+    instrument->Count( instAccesses );
+
+    if( hit ) 
+    {
+        unsigned char &hits = instLineHits[ (size_t)setIndex * assoc + way ];
+
+        if( accessType != ACCESS_WRITEBACK && hits < 255 ) hits++;
+    }
+    else 
+    {
+        instrument->Count( instMisses );
+
+        if( way != -1 ) 
+        {
+            instLineHits[ (size_t)setIndex * assoc + way ] = 0;
+
+            if( instPosition != CRC_INST_POSITION_NONE ) instrument->Record( instInsertion, InstrumentPosition( setIndex, way ) );
+        }
+    }
+
+    if( instrument->Tick() ) 
+    {
+        InstrumentGauges();
+        instrument->Sample();
+    }
+}
 
 #endif
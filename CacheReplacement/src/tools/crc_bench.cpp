@@ -0,0 +1,1432 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// crc_bench: performance benchmarks for the LLC simulator.                   //
+//                                                                            //
+// Every benchmark replays a synthetic, deterministic access stream through   //
+// the cache model and reports accesses per second. The stream mixes a hot    //
+// working set that fits in the cache, random accesses to a footprint much    //
+// larger than the cache and a sequential stream, so both the hit and the     //
+// miss paths are exercised.                                                  //
+//                                                                            //
+// Usage: crc_bench <benchmark> [-cache UL3:size_KB:line:assoc]               //
+//                              [-LLCrepl policy] [-n accesses]               //
+//                              [-workers max] [-o trace_file]                //
+//                                                                            //
+//   tagstore   original LINE_STATE** layout vs the flat tag store            //
+//   lookup     tag match kernels on 4-, 8-, 16- and 32-way sets              //
+//   batch      LookupAndFillCache per access vs LookupAndFillBatch; use a    //
+//              cache larger than the host caches, e.g. -cache UL3:65536:64:16//
+//   policy     generic vs policy-specialized access path, all but OPT        //
+//   lru        packed true LRU vs the original stack positions, 4-64 ways    //
+//   recency    tree-PLRU and NRU vs true LRU at 2-64 ways: speed, misses     //
+//   rrip       one-pass RRIP victim search vs the original aging loop        //
+//   parallel   set-sharded engine with 1, 2, 4, ... -workers threads, in     //
+//              approximate (epoch) and relaxed mode, against the sequential  //
+//              cache                                                         //
+//   sampling   set sampling (stride and hash, 1 in 4, 16 and 64 sets)        //
+//              against the full cache: speedup and miss rate estimate        //
+//   mix        4-thread mix with one streaming thread: DRRIP with one shared //
+//              selector vs thread-aware DRRIP, per-thread miss rates         //
+//   duel       set dueling: tournaments of 2-6 policies must pick the one    //
+//              with the fewest misses; leader sets hit by strided sweeps,    //
+//              hashed placement vs the original % 33 / % 31 layout           //
+//   instrument replacement policy probes (builds with CRC_INSTRUMENT): cost  //
+//              per access, and their totals against the cache statistics     //
+//   gentrace   write the synthetic stream to a trace file (-o file)          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <time.h>
+#include <unistd.h>
+#include "crc_cache.h"
+#include "crc_parallel.h"
+#include "crc_trace.h"
+
+typedef struct
+{
+    UINT32  cacheSize;
+    UINT32  linesize;
+    UINT32  assoc;
+    UINT32  policy;
+    COUNTER numRefs;
+    UINT32  maxWorkers;
+    const char *tracePath;
+} BENCH_CONFIG;
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Helpers: timer, random numbers and the synthetic stream                    //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static double BenchNow()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline unsigned long long BenchRand( unsigned long long &state )
+{
+    // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+static Access *MakeStream( const BENCH_CONFIG &cfg )
+{
+    Access *refs = new Access[ cfg.numRefs ];
+
+    unsigned long long seed  = 0x9e3779b97f4a7c15ULL;
+    unsigned long long lines = cfg.cacheSize / cfg.linesize;
+    unsigned long long hot   = lines / 2;
+    unsigned long long cold  = lines * 8;
+    unsigned long long seq   = 0;
+
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        unsigned long long r    = BenchRand( seed );
+        unsigned long long pick = r % 100;
+        unsigned long long line;
+
+        if( pick < 60 )      line = (r >> 8) % hot;
+        else if( pick < 90 ) line = hot + (r >> 8) % cold;
+        else                 line = hot + cold + (seq++);
+
+        refs[i].tid        = 0;
+        refs[i].PC         = 0x400000 + (pick % 32) * 4;
+        refs[i].paddr      = line * cfg.linesize + ((r >> 40) % cfg.linesize);
+        refs[i].accessType = (pick % 10 < 7) ? ACCESS_LOAD : ((pick % 10 < 9) ? ACCESS_STORE : ACCESS_IFETCH);
+    }
+
+    return refs;
+}
+
+static void PrintRate( const char *name, double secs, COUNTER refs, COUNTER hits )
+{
+    printf( "  %-16s %14.0f %12.2f %14llu\n", name, refs / secs, secs * 1e9 / refs, hits );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The original CRC_CACHE storage: one LINE_STATE array per set behind a      //
+// LINE_STATE**. Only the lookup and fill path is reproduced, with the same   //
+// victim selection, so hit counts must match the flat tag store exactly.     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class LEGACY_CRC_CACHE
+{
+  private:
+    UINT32 numsets;
+    UINT32 assoc;
+    UINT32 lineShift;
+    UINT32 indexShift;
+    UINT32 indexMask;
+
+    LINE_STATE               **cache;
+    CACHE_REPLACEMENT_STATE  *cacheReplState;
+
+    COUNTER lookups[ ACCESS_MAX ];
+    COUNTER misses[ ACCESS_MAX ];
+    COUNTER hits[ ACCESS_MAX ];
+    COUNTER mytimer;
+
+  public:
+    LEGACY_CRC_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _linesize, UINT32 _pol )
+    {
+        numsets    = _cacheSize / (_linesize * _assoc);
+        assoc      = _assoc;
+        lineShift  = CRC_FloorLog2( _linesize );
+        indexShift = CRC_FloorLog2( numsets );
+        indexMask  = (1 << indexShift) - 1;
+
+        cache = new LINE_STATE* [ numsets ];
+        for(UINT32 setIndex=0; setIndex<numsets; setIndex++)
+        {
+            cache[ setIndex ] = new LINE_STATE[ assoc ];
+            for(UINT32 way=0; way<assoc; way++)
+            {
+                cache[ setIndex ][ way ].tag         = 0xdeaddead;
+                cache[ setIndex ][ way ].valid       = false;
+                cache[ setIndex ][ way ].dirty       = false;
+                cache[ setIndex ][ way ].sharing_dir = 0;
+            }
+        }
+
+        cacheReplState = new CACHE_REPLACEMENT_STATE( numsets, assoc, _pol );
+
+        memset( lookups, 0, sizeof(lookups) );
+        memset( misses, 0, sizeof(misses) );
+        memset( hits, 0, sizeof(hits) );
+        mytimer = 0;
+    }
+
+    ~LEGACY_CRC_CACHE()
+    {
+        for(UINT32 setIndex=0; setIndex<numsets; setIndex++) delete [] cache[ setIndex ];
+        delete [] cache;
+        delete cacheReplState;
+    }
+
+    bool LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) __attribute__((noinline))
+    {
+        ++mytimer;
+        cacheReplState->IncrementTimer();
+
+        lookups[ accessType ]++;
+
+        UINT32 setIndex   = (paddr >> lineShift) & indexMask;
+        Addr_t tag        = (paddr >> lineShift) >> indexShift;
+        LINE_STATE *set   = cache[ setIndex ];
+        INT32 wayID       = -1;
+
+        for(UINT32 way=0; way<assoc; way++)
+        {
+            if( set[way].valid && (set[way].tag == tag) ) { wayID = way; break; }
+        }
+
+        if( wayID == -1 )
+        {
+            for(UINT32 way=0; way<assoc; way++)
+            {
+                if( set[way].valid == false ) { wayID = way; break; }
+            }
+
+            if( wayID == -1 )
+            {
+                wayID = cacheReplState->GetVictimInSet( tid, setIndex, set, assoc, PC, paddr, accessType );
+            }
+
+            if( wayID != -1 )
+            {
+                LINE_STATE *currLine  = &set[ wayID ];
+                currLine->valid       = true;
+                currLine->tag         = tag;
+                currLine->dirty       = IS_STORE( accessType );
+                currLine->sharing_dir = (1<<tid);
+
+                cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, false );
+            }
+
+            misses[ accessType ]++;
+            return false;
+        }
+
+        LINE_STATE *currLine    = &set[ wayID ];
+        currLine->dirty        |= IS_STORE( accessType );
+        currLine->sharing_dir  |= (1<<tid);
+
+        if( accessType != ACCESS_WRITEBACK )
+        {
+            cacheReplState->UpdateReplacementState( setIndex, wayID, currLine, tid, PC, accessType, true );
+        }
+
+        hits[ accessType ]++;
+        return true;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: original pointer-chased layout vs the flat tag store            //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+template <class CACHE>
+static double RunStream( CACHE &cache, const Access *refs, COUNTER n, COUNTER &hits )
+{
+    // Random and DRRIP draw from rand(), so give both layouts the same sequence
+    srand( 1 );
+
+    hits = 0;
+
+    double start = BenchNow();
+    for(COUNTER i=0; i<n; i++)
+    {
+        hits += cache.LookupAndFillCache( 0, refs[i].PC, refs[i].paddr, refs[i].accessType );
+    }
+    return BenchNow() - start;
+}
+
+static int BenchTagStore( const BENCH_CONFIG &cfg )
+{
+    Access *refs = MakeStream( cfg );
+
+    COUNTER legacyHits, flatHits;
+    double  legacySecs, flatSecs;
+
+    {
+        LEGACY_CRC_CACHE cache( cfg.cacheSize, cfg.assoc, cfg.linesize, cfg.policy );
+        legacySecs = RunStream( cache, refs, cfg.numRefs, legacyHits );
+    }
+    {
+        CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy );
+        flatSecs = RunStream( cache, refs, cfg.numRefs, flatHits );
+    }
+
+    printf( "  %-16s %14s %12s %14s\n", "layout", "accesses/sec", "ns/access", "hits" );
+    PrintRate( "LINE_STATE**", legacySecs, cfg.numRefs, legacyHits );
+    PrintRate( "flat tag store", flatSecs, cfg.numRefs, flatHits );
+    printf( "  speedup: %.2fx\n", legacySecs / flatSecs );
+
+    delete [] refs;
+
+    if( legacyHits != flatHits )
+    {
+        printf( "ERROR: hit counts differ between layouts\n" );
+        return 1;
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: tag match kernels. Half of the lookups hit a random way, the    //
+// other half miss, over 256 sets of each associativity so the tags stay in   //
+// the host caches and the kernels themselves are measured.                   //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int BenchLookup( const BENCH_CONFIG &cfg )
+{
+    const UINT32 numsets    = 256;
+    const UINT32 ways[]     = { 4, 8, 16, 32 };
+    const UINT32 numQueries = 1 << 16;
+
+    unsigned long long seed = 0x2545f4914f6cdd1dULL;
+    int status = 0;
+
+    printf( "  %-6s", "ways" );
+    for(UINT32 k=0; k<CRC_TAG_MATCH_MAX; k++) printf( " %16s", CRC_TagMatchName( k ) );
+    printf( "   (lookups/sec)\n" );
+
+    for(UINT32 w=0; w<sizeof(ways)/sizeof(ways[0]); w++)
+    {
+        UINT32  assoc   = ways[w];
+        Addr_t *tags    = (Addr_t *) CRC_AlignedAlloc( (size_t)numsets * assoc * sizeof(Addr_t) );
+        UINT32 *qset    = new UINT32[ numQueries ];
+        Addr_t *qtag    = new Addr_t[ numQueries ];
+        INT32  *qway    = new INT32[ numQueries ];
+
+        for(size_t i=0; i<(size_t)numsets * assoc; i++) tags[i] = BenchRand( seed ) >> 20;
+
+        for(UINT32 q=0; q<numQueries; q++)
+        {
+            unsigned long long r = BenchRand( seed );
+
+            qset[q] = r % numsets;
+            qway[q] = ((r >> 32) & 1) ? (INT32)((r >> 33) % assoc) : -1;
+            qtag[q] = (qway[q] == -1) ? (BenchRand( seed ) >> 20) | (1ULL << 62)
+                                      : tags[ (size_t)qset[q] * assoc + qway[q] ];
+        }
+
+        printf( "  %-6u", assoc );
+
+        for(UINT32 k=0; k<CRC_TAG_MATCH_MAX; k++)
+        {
+            if( !CRC_TagMatchSupported( k ) )
+            {
+                printf( " %16s", "n/a" );
+                continue;
+            }
+
+            CRC_TAG_MATCH_FN match = CRC_TagMatchFunction( k );
+            COUNTER errors = 0;
+
+            double start = BenchNow();
+            for(COUNTER i=0; i<cfg.numRefs; i++)
+            {
+                UINT32 q = i & (numQueries - 1);
+                errors += match( tags + (size_t)qset[q] * assoc, assoc, qtag[q] ) != qway[q];
+            }
+            double secs = BenchNow() - start;
+
+            printf( " %16.0f", cfg.numRefs / secs );
+
+            if( errors ) status = 1;
+        }
+
+        printf( "\n" );
+
+        CRC_AlignedFree( tags );
+        delete [] qset;
+        delete [] qtag;
+        delete [] qway;
+    }
+
+    if( status ) printf( "ERROR: a kernel returned the wrong way\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: one call per access vs batches handed to LookupAndFillBatch,    //
+// which prefetches the sets of upcoming accesses. Both runs must produce     //
+// the same hit/miss outcome for every access.                                //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+#define BENCH_BATCH_SIZE 4096
+
+static int BenchBatch( const BENCH_CONFIG &cfg )
+{
+    Access *refs       = MakeStream( cfg );
+    bool   *singleHits = new bool[ cfg.numRefs ];
+    bool   *batchHits  = new bool[ cfg.numRefs ];
+
+    COUNTER hits[2] = { 0, 0 };
+    double  secs[2];
+
+    {
+        CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy );
+
+        double start = BenchNow();
+        for(COUNTER i=0; i<cfg.numRefs; i++)
+        {
+            singleHits[i] = cache.LookupAndFillCache( refs[i].tid, refs[i].PC, refs[i].paddr, refs[i].accessType );
+        }
+        secs[0] = BenchNow() - start;
+    }
+    {
+        CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy );
+
+        double start = BenchNow();
+        for(COUNTER i=0; i<cfg.numRefs; i+=BENCH_BATCH_SIZE)
+        {
+            size_t n = (cfg.numRefs - i < BENCH_BATCH_SIZE) ? cfg.numRefs - i : BENCH_BATCH_SIZE;
+            cache.LookupAndFillBatch( refs + i, n, batchHits + i );
+        }
+        secs[1] = BenchNow() - start;
+    }
+
+    COUNTER mismatches = 0;
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        hits[0]    += singleHits[i];
+        hits[1]    += batchHits[i];
+        mismatches += singleHits[i] != batchHits[i];
+    }
+
+    printf( "  %-16s %14s %12s %14s\n", "interface", "accesses/sec", "ns/access", "hits" );
+    PrintRate( "single", secs[0], cfg.numRefs, hits[0] );
+    PrintRate( "batch", secs[1], cfg.numRefs, hits[1] );
+    printf( "  speedup: %.2fx (batch %u, prefetch distance %u)\n", secs[0] / secs[1],
+            BENCH_BATCH_SIZE, CRC_BATCH_PREFETCH_DISTANCE );
+
+    delete [] refs;
+    delete [] singleHits;
+    delete [] batchHits;
+
+    if( mismatches )
+    {
+        printf( "ERROR: %llu accesses differ between single and batch\n", mismatches );
+        return 1;
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: the generic access path, which dispatches on the policy number  //
+// on every access, against the path specialized for the policy, for every    //
+// policy but OPT (-LLCrepl is ignored). Both paths must miss on exactly the  //
+// same accesses.                                                             //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static double RunPolicyPath( const BENCH_CONFIG &cfg, const Access *refs, UINT32 policy, bool specialized,
+                             bool batch, COUNTER &misses )
+{
+    CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, policy );
+    cache.SelectAccessPath( specialized );
+
+    double start = BenchNow();
+    if( batch )
+    {
+        for(COUNTER i=0; i<cfg.numRefs; i+=BENCH_BATCH_SIZE)
+        {
+            size_t n = (cfg.numRefs - i < BENCH_BATCH_SIZE) ? cfg.numRefs - i : BENCH_BATCH_SIZE;
+            cache.LookupAndFillBatch( refs + i, n, NULL );
+        }
+    }
+    else
+    {
+        for(COUNTER i=0; i<cfg.numRefs; i++)
+        {
+            cache.LookupAndFillCache( refs[i].tid, refs[i].PC, refs[i].paddr, refs[i].accessType );
+        }
+    }
+    double secs = BenchNow() - start;
+
+    misses = cache.ThreadDemandMissStats( 0 );
+    return secs;
+}
+
+static int BenchPolicy( const BENCH_CONFIG &cfg )
+{
+    static const char *names[]  = { "LRU", "Random", "DRRIP", "SHiP", "Hawkeye", "OPT", "OPT-b", "TreePLRU", "NRU", "EAF",
+                                    "SDBP", "SDBP-b", "MPP", "ARC" };
+    static const char *ifaces[] = { "single", "batch" };
+
+    Access *refs   = MakeStream( cfg );
+    int     status = 0;
+
+    printf( "  %-8s %-8s %16s %16s %9s %14s\n", "policy", "calls", "generic ns/acc", "special ns/acc", "speedup", "misses" );
+
+    for(UINT32 policy=CRC_REPL_LRU; policy<=CRC_REPL_ARC; policy++)
+    {
+        // OPT needs a next-use index of the stream
+        if( policy == CRC_REPL_OPT || policy == CRC_REPL_OPT_BYPASS ) continue;
+
+        for(UINT32 batch=0; batch<2; batch++)
+        {
+            COUNTER genericMisses, specialMisses;
+            double  genericSecs = RunPolicyPath( cfg, refs, policy, false, batch, genericMisses );
+            double  specialSecs = RunPolicyPath( cfg, refs, policy, true, batch, specialMisses );
+
+            printf( "  %-8s %-8s %16.2f %16.2f %8.2fx %14llu%s\n", names[ policy ], ifaces[ batch ],
+                    genericSecs * 1e9 / cfg.numRefs, specialSecs * 1e9 / cfg.numRefs, genericSecs / specialSecs,
+                    specialMisses, (genericMisses == specialMisses) ? "" : "  MISMATCH" );
+
+            if( genericMisses != specialMisses ) status = 1;
+        }
+    }
+
+    delete [] refs;
+
+    if( status ) printf( "ERROR: the generic and specialized paths disagree\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The original true LRU: a 32-bit stack position per line, a scan for the    //
+// bottom of the stack on a miss and a pass over every way on each update.    //
+// It sits on a plain tag array that fills invalid ways lowest first, like    //
+// CRC_CACHE, and skips the update on writeback hits.                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+class LEGACY_LRU_CACHE
+{
+  private:
+    UINT32  numsets;
+    UINT32  assoc;
+    UINT32  lineShift;
+    UINT32  indexShift;
+    UINT32  indexMask;
+
+    Addr_t *tags;
+    bool   *valid;
+    UINT32 *position;
+
+  public:
+    LEGACY_LRU_CACHE( UINT32 _cacheSize, UINT32 _assoc, UINT32 _linesize )
+    {
+        numsets    = _cacheSize / (_linesize * _assoc);
+        assoc      = _assoc;
+        lineShift  = CRC_FloorLog2( _linesize );
+        indexShift = CRC_FloorLog2( numsets );
+        indexMask  = (1 << indexShift) - 1;
+
+        tags     = new Addr_t[ (size_t)numsets * assoc ];
+        valid    = new bool[ (size_t)numsets * assoc ];
+        position = new UINT32[ (size_t)numsets * assoc ];
+
+        for(size_t i=0; i<(size_t)numsets * assoc; i++)
+        {
+            valid[i]    = false;
+            position[i] = i % assoc;
+        }
+    }
+
+    ~LEGACY_LRU_CACHE()
+    {
+        delete [] tags;
+        delete [] valid;
+        delete [] position;
+    }
+
+    bool LookupAndFillCache( UINT32 tid, Addr_t PC, Addr_t paddr, UINT32 accessType ) __attribute__((noinline))
+    {
+        UINT32  setIndex = (paddr >> lineShift) & indexMask;
+        Addr_t  tag      = (paddr >> lineShift) >> indexShift;
+        size_t  base     = (size_t)setIndex * assoc;
+        INT32   wayID    = -1;
+
+        for(UINT32 way=0; way<assoc; way++)
+        {
+            if( valid[ base + way ] && tags[ base + way ] == tag ) { wayID = way; break; }
+        }
+
+        if( wayID != -1 )
+        {
+            if( accessType != ACCESS_WRITEBACK ) Update( base, wayID );
+            return true;
+        }
+
+        for(UINT32 way=0; way<assoc; way++)
+        {
+            if( !valid[ base + way ] ) { wayID = way; break; }
+        }
+
+        if( wayID == -1 )
+        {
+            for(UINT32 way=0; way<assoc; way++)
+            {
+                if( position[ base + way ] == assoc - 1 ) { wayID = way; break; }
+            }
+        }
+
+        valid[ base + wayID ] = true;
+        tags[ base + wayID ]  = tag;
+        Update( base, wayID );
+
+        return false;
+    }
+
+  private:
+    void Update( size_t base, INT32 wayID )
+    {
+        UINT32 curr = position[ base + wayID ];
+
+        for(UINT32 way=0; way<assoc; way++)
+        {
+            if( position[ base + way ] < curr ) position[ base + way ]++;
+        }
+
+        position[ base + wayID ] = 0;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: packed true LRU against the original stack positions, at        //
+// 4 to 64 ways. Every access must hit or miss in both.                       //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int BenchLru( const BENCH_CONFIG &cfg )
+{
+    const UINT32 ways[] = { 4, 8, 16, 32, 64 };
+
+    Access *refs       = MakeStream( cfg );
+    bool   *legacyHits = new bool[ cfg.numRefs ];
+    int     status     = 0;
+
+    printf( "  %-6s %14s %14s %9s %12s %12s %14s\n", "ways", "legacy ns/acc", "packed ns/acc", "speedup",
+            "legacy B/set", "packed B/set", "hits" );
+
+    for(UINT32 w=0; w<sizeof(ways)/sizeof(ways[0]); w++)
+    {
+        UINT32  assoc      = ways[w];
+        COUNTER hits       = 0;
+        COUNTER mismatches = 0;
+        double  legacySecs, packedSecs;
+
+        {
+            LEGACY_LRU_CACHE cache( cfg.cacheSize, assoc, cfg.linesize );
+
+            double start = BenchNow();
+            for(COUNTER i=0; i<cfg.numRefs; i++)
+            {
+                legacyHits[i] = cache.LookupAndFillCache( 0, refs[i].PC, refs[i].paddr, refs[i].accessType );
+            }
+            legacySecs = BenchNow() - start;
+        }
+        {
+            CRC_CACHE cache( cfg.cacheSize, assoc, 1, cfg.linesize, CRC_REPL_LRU );
+
+            double start = BenchNow();
+            for(COUNTER i=0; i<cfg.numRefs; i++)
+            {
+                bool hit = cache.LookupAndFillCache( 0, refs[i].PC, refs[i].paddr, refs[i].accessType );
+
+                hits       += hit;
+                mismatches += hit != legacyHits[i];
+            }
+            packedSecs = BenchNow() - start;
+        }
+
+        printf( "  %-6u %14.2f %14.2f %8.2fx %12u %12u %14llu%s\n", assoc,
+                legacySecs * 1e9 / cfg.numRefs, packedSecs * 1e9 / cfg.numRefs, legacySecs / packedSecs,
+                (UINT32)(assoc * sizeof(UINT32)), (assoc <= CRC_LRU_PACKED_WAYS) ? 8 : assoc, hits,
+                mismatches ? "  MISMATCH" : "" );
+
+        if( mismatches ) status = 1;
+    }
+
+    delete [] refs;
+    delete [] legacyHits;
+
+    if( status ) printf( "ERROR: packed LRU and the original stack positions disagree\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: tree-PLRU and NRU against true LRU at 2 to 64 ways, including   //
+// associativities that are not a power of two. The number of sets is that    //
+// of the -cache configuration, so the capacity grows with the ways. Reports  //
+// ns per access and miss rate of each policy and its bits of state per set.  //
+// At 2 ways both approximations are exact and must miss where LRU does.      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static double RunRecency( const BENCH_CONFIG &cfg, const Access *refs, UINT32 cacheSize, UINT32 assoc,
+                          UINT32 policy, bool *hits, COUNTER &misses )
+{
+    CRC_CACHE cache( cacheSize, assoc, 1, cfg.linesize, policy );
+
+    misses = 0;
+
+    double start = BenchNow();
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        bool hit = cache.LookupAndFillCache( 0, refs[i].PC, refs[i].paddr, refs[i].accessType );
+
+        misses += !hit;
+        hits[i] = hit;
+    }
+    return BenchNow() - start;
+}
+
+static int BenchRecency( const BENCH_CONFIG &cfg )
+{
+    const UINT32 ways[]     = { 2, 4, 8, 12, 16, 24, 32, 48, 64 };
+    const UINT32 policies[] = { CRC_REPL_LRU, CRC_REPL_TREE_PLRU, CRC_REPL_NRU };
+
+    UINT32  sets     = cfg.cacheSize / (cfg.linesize * cfg.assoc);
+    Access *refs     = MakeStream( cfg );
+    bool   *lruHits  = new bool[ cfg.numRefs ];
+    bool   *hits     = new bool[ cfg.numRefs ];
+    int     status   = 0;
+
+    printf( "  %-5s %-9s %9s %9s %9s %10s %10s %10s %8s %8s\n", "ways", "KB", "LRU ns", "PLRU ns", "NRU ns",
+            "LRU miss", "PLRU miss", "NRU miss", "PLRU b", "NRU b" );
+
+    for(UINT32 w=0; w<sizeof(ways)/sizeof(ways[0]); w++)
+    {
+        UINT32  assoc     = ways[w];
+        UINT32  cacheSize = sets * cfg.linesize * assoc;
+        double  secs[3];
+        COUNTER misses[3];
+        COUNTER mismatches = 0;
+
+        for(UINT32 p=0; p<3; p++)
+        {
+            secs[p] = RunRecency( cfg, refs, cacheSize, assoc, policies[p], p ? hits : lruHits, misses[p] );
+
+            if( p && assoc == 2 )
+            {
+                for(COUNTER i=0; i<cfg.numRefs; i++) mismatches += hits[i] != lruHits[i];
+            }
+        }
+
+        CACHE_REPLACEMENT_STATE plru( sets, assoc, CRC_REPL_TREE_PLRU );
+        CACHE_REPLACEMENT_STATE nru( sets, assoc, CRC_REPL_NRU );
+
+        printf( "  %-5u %-9u %9.2f %9.2f %9.2f %9.2f%% %9.2f%% %9.2f%% %8.2f %8.2f%s\n", assoc, cacheSize / 1024,
+                secs[0] * 1e9 / cfg.numRefs, secs[1] * 1e9 / cfg.numRefs, secs[2] * 1e9 / cfg.numRefs,
+                100.0 * misses[0] / cfg.numRefs, 100.0 * misses[1] / cfg.numRefs, 100.0 * misses[2] / cfg.numRefs,
+                8.0 * plru.MetadataBytes() / sets, 8.0 * nru.MetadataBytes() / sets, mismatches ? "  MISMATCH" : "" );
+
+        if( mismatches ) status = 1;
+    }
+
+    delete [] refs;
+    delete [] lruHits;
+    delete [] hits;
+
+    if( status ) printf( "ERROR: 2-way tree-PLRU or NRU disagrees with LRU\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// The original RRIP victim search: scan for RRIP_MAX-1, and if no way is     //
+// there, age every way by one and scan again                                 //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static INT32 LegacyRripVictim( UINT32 *rrpv, UINT32 assoc, UINT32 rripMax )
+{
+    while( true )
+    {
+        for(UINT32 way=0; way<assoc; way++)
+        {
+            if( rrpv[way] == rripMax - 1 ) return way;
+        }
+
+        for(UINT32 way=0; way<assoc; way++) rrpv[way]++;
+    }
+}
+
+// Pack RRPVs into the 2-bit fields of CACHE_REPLACEMENT_STATE
+static void PackRrpv( const UINT32 *rrpv, UINT32 assoc, UINT32 *words )
+{
+    for(UINT32 w=0; w<(assoc + CRC_RRPV_PER_WORD - 1) / CRC_RRPV_PER_WORD; w++) words[w] = 0;
+
+    for(UINT32 way=0; way<assoc; way++)
+    {
+        words[ way / CRC_RRPV_PER_WORD ] |= rrpv[way] << (CRC_RRPV_BITS * (way % CRC_RRPV_PER_WORD));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: one-pass RRIP victim search on packed 2-bit RRPVs against the   //
+// original one on 32-bit RRPVs, on sets whose highest RRPV is spread evenly  //
+// over 0 .. RRIP_MAX-1 (0 to 3 aging steps). Each search starts from a fresh //
+// copy of the set; victims and aged RRPVs must match.                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int BenchRrip( const BENCH_CONFIG &cfg )
+{
+    const UINT32 rripMax    = 1 << CRC_RRPV_BITS;
+    const UINT32 ways[]     = { 4, 8, 12, 16, 32 };
+    const UINT32 numStates  = 1 << 12;
+
+    unsigned long long seed = 0x2545f4914f6cdd1dULL;
+    int status = 0;
+
+    printf( "  %-6s %16s %16s %9s\n", "ways", "legacy ns/miss", "one-pass ns/miss", "speedup" );
+
+    for(UINT32 w=0; w<sizeof(ways)/sizeof(ways[0]); w++)
+    {
+        UINT32  assoc     = ways[w];
+        UINT32  numWords  = (assoc + CRC_RRPV_PER_WORD - 1) / CRC_RRPV_PER_WORD;
+        UINT32  lastWays  = assoc - (numWords - 1) * CRC_RRPV_PER_WORD;
+        UINT32  lastMask  = CRC_RRPV_LOW_BITS >> (CRC_RRPV_BITS * (CRC_RRPV_PER_WORD - lastWays));
+        UINT32 *states    = new UINT32[ (size_t)numStates * assoc ];
+        UINT32 *packed    = new UINT32[ (size_t)numStates * numWords ];
+        UINT32 *legacy    = new UINT32[ assoc ];
+        UINT32 *fast      = new UINT32[ numWords ];
+        UINT32 *expected  = new UINT32[ numWords ];
+        COUNTER errors    = 0;
+
+        for(UINT32 q=0; q<numStates; q++)
+        {
+            UINT32 *set  = states + (size_t)q * assoc;
+            UINT32  high = q % rripMax;
+
+            for(UINT32 way=0; way<assoc; way++) set[way] = BenchRand( seed ) % (high + 1);
+            set[ BenchRand( seed ) % assoc ] = high;
+
+            PackRrpv( set, assoc, packed + (size_t)q * numWords );
+        }
+
+        for(UINT32 q=0; q<numStates; q++)
+        {
+            memcpy( legacy, states + (size_t)q * assoc, assoc * sizeof(UINT32) );
+            memcpy( fast, packed + (size_t)q * numWords, numWords * sizeof(UINT32) );
+
+            errors += LegacyRripVictim( legacy, assoc, rripMax ) != CRC_RRIP_Victim( fast, numWords, lastMask );
+
+            PackRrpv( legacy, assoc, expected );
+            errors += memcmp( expected, fast, numWords * sizeof(UINT32) ) != 0;
+        }
+
+        double  secs[2];
+        COUNTER sum = 0;
+        volatile COUNTER sink;
+
+        for(UINT32 k=0; k<2; k++)
+        {
+            double start = BenchNow();
+            for(COUNTER i=0; i<cfg.numRefs; i++)
+            {
+                UINT32 q = i & (numStates - 1);
+
+                if( k )
+                {
+                    memcpy( fast, packed + (size_t)q * numWords, numWords * sizeof(UINT32) );
+                    sum += CRC_RRIP_Victim( fast, numWords, lastMask );
+                }
+                else
+                {
+                    memcpy( legacy, states + (size_t)q * assoc, assoc * sizeof(UINT32) );
+                    sum += LegacyRripVictim( legacy, assoc, rripMax );
+                }
+            }
+            secs[k] = BenchNow() - start;
+        }
+
+        // keep the victims alive
+        sink = sum;
+        (void)sink;
+
+        printf( "  %-6u %16.2f %16.2f %8.2fx\n", assoc, secs[0] * 1e9 / cfg.numRefs, secs[1] * 1e9 / cfg.numRefs,
+                secs[0] / secs[1] );
+
+        if( errors ) status = 1;
+
+        delete [] states;
+        delete [] packed;
+        delete [] legacy;
+        delete [] fast;
+        delete [] expected;
+    }
+
+    if( status ) printf( "ERROR: the one-pass search picked another victim or aged the set differently\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: the set-sharded engine. The stream is replayed through the      //
+// sequential cache and then through 1, 2, 4, ... workers in both sync        //
+// modes. Demand misses are compared with the sequential run; LRU,            //
+// tree-PLRU, NRU and ARC have neither global state nor random draws and must //
+// match exactly with any number of workers, as must every policy in          //
+// approximate mode with a single worker. The other policies must stay within //
+// BENCH_PARALLEL_MAX_DEVIATION in approximate mode, where their selectors    //
+// and predictors are merged every epoch; without the merge (relaxed mode)    //
+// the predictor policies drift several times further. OPT cannot be sharded. //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+#define BENCH_PARALLEL_MAX_DEVIATION 1.0    // percent of the sequential misses
+
+static int BenchParallel( const BENCH_CONFIG &cfg )
+{
+    static const char *modes[] = { "approx", "relaxed" };
+
+    if( cfg.policy == CRC_REPL_OPT || cfg.policy == CRC_REPL_OPT_BYPASS )
+    {
+        fprintf( stderr, "crc_bench: parallel cannot run OPT (-LLCrepl %u or %u)\n", CRC_REPL_OPT, CRC_REPL_OPT_BYPASS );
+        return 1;
+    }
+
+    Access *refs   = MakeStream( cfg );
+    int     status = 0;
+
+    COUNTER seqMisses;
+    double  seqSecs;
+
+    {
+        CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy );
+
+        double start = BenchNow();
+        for(COUNTER i=0; i<cfg.numRefs; i+=BENCH_BATCH_SIZE)
+        {
+            size_t n = (cfg.numRefs - i < BENCH_BATCH_SIZE) ? cfg.numRefs - i : BENCH_BATCH_SIZE;
+            cache.LookupAndFillBatch( refs + i, n, NULL );
+        }
+        seqSecs   = BenchNow() - start;
+        seqMisses = cache.ThreadDemandMissStats( 0 );
+    }
+
+    printf( "  %-8s %8s %14s %9s %14s %11s\n", "mode", "workers", "accesses/sec", "speedup", "misses", "deviation" );
+    printf( "  %-8s %8s %14.0f %8.2fx %14llu %10.3f%%\n", "sequential", "-", cfg.numRefs / seqSecs, 1.0, seqMisses, 0.0 );
+
+    for(UINT32 mode=CRC_SYNC_APPROX; mode<=CRC_SYNC_RELAXED; mode++)
+    {
+        for(UINT32 workers=1; workers<=cfg.maxWorkers; workers*=2)
+        {
+            CRC_PARALLEL_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy, workers, mode );
+
+            double start = BenchNow();
+            for(COUNTER i=0; i<cfg.numRefs; i+=BENCH_BATCH_SIZE)
+            {
+                size_t n = (cfg.numRefs - i < BENCH_BATCH_SIZE) ? cfg.numRefs - i : BENCH_BATCH_SIZE;
+                cache.LookupAndFillBatch( refs + i, n );
+            }
+            cache.Drain();
+            double secs = BenchNow() - start;
+
+            COUNTER misses    = cache.ThreadDemandMissStats( 0 );
+            double  deviation = 100.0 * ((double)misses - (double)seqMisses) / (double)seqMisses;
+
+            printf( "  %-8s %8u %14.0f %8.2fx %14llu %10.3f%%\n", modes[ mode ], workers,
+                    cfg.numRefs / secs, seqSecs / secs, misses, deviation );
+
+            bool exact = (cfg.policy == CRC_REPL_LRU || cfg.policy == CRC_REPL_TREE_PLRU || cfg.policy == CRC_REPL_NRU ||
+                          cfg.policy == CRC_REPL_ARC) || (mode == CRC_SYNC_APPROX && workers == 1);
+
+            if( exact && misses != seqMisses ) status = 1;
+            if( mode == CRC_SYNC_APPROX && fabs( deviation ) > BENCH_PARALLEL_MAX_DEVIATION ) status = 1;
+        }
+    }
+
+    delete [] refs;
+
+    if( status ) printf( "ERROR: a run that must match the sequential cache did not, or an approximate run deviated more than %.1f%%\n",
+                         BENCH_PARALLEL_MAX_DEVIATION );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: set sampling. The full cache gives the reference miss rate;     //
+// each sampled run reports its estimate, the 95% confidence half width and   //
+// whether the reference falls inside it.                                     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static double RunSampling( const BENCH_CONFIG &cfg, const Access *refs, UINT32 mode, UINT32 k,
+                           double &missRate, double &halfWidth, UINT32 &simulated )
+{
+    CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, cfg.policy );
+    cache.SetSampling( mode, k );
+
+    double start = BenchNow();
+    for(COUNTER i=0; i<cfg.numRefs; i+=BENCH_BATCH_SIZE)
+    {
+        size_t n = (cfg.numRefs - i < BENCH_BATCH_SIZE) ? cfg.numRefs - i : BENCH_BATCH_SIZE;
+        cache.LookupAndFillBatch( refs + i, n, NULL );
+    }
+    double secs = BenchNow() - start;
+
+    CRC_SET_SAMPLER *sampler = cache.SetSampler();
+
+    if( sampler )
+    {
+        missRate  = sampler->EstimateMissRate( ACCESS_MAX, halfWidth );
+        simulated = sampler->SimulatedSets();
+    }
+    else
+    {
+        missRate  = (double)cache.ThreadDemandMissStats( 0 ) / cache.ThreadDemandLookupStats( 0 );
+        halfWidth = 0;
+        simulated = cfg.cacheSize / (cfg.linesize * cfg.assoc);
+    }
+
+    return secs;
+}
+
+static int BenchSampling( const BENCH_CONFIG &cfg )
+{
+    static const char   *modes[]  = { "full", "stride", "hash" };
+    static const UINT32  ratios[] = { 4, 16, 64 };
+
+    Access *refs = MakeStream( cfg );
+
+    double fullRate, fullHW;
+    UINT32 fullSets;
+    double fullSecs = RunSampling( cfg, refs, CRC_SAMPLE_NONE, 1, fullRate, fullHW, fullSets );
+
+    printf( "  %-8s %6s %9s %14s %9s %11s %9s %8s\n", "mode", "1/k", "sets", "accesses/sec", "speedup", "miss_rate", "ci95", "error" );
+    printf( "  %-8s %6s %9u %14.0f %8.2fx %10.4f%% %8.4f%% %7.4f%%\n", modes[0], "-", fullSets,
+            cfg.numRefs / fullSecs, 1.0, 100.0 * fullRate, 0.0, 0.0 );
+
+    for(UINT32 mode=CRC_SAMPLE_STRIDE; mode<=CRC_SAMPLE_HASH; mode++)
+    {
+        for(UINT32 r=0; r<sizeof(ratios)/sizeof(ratios[0]); r++)
+        {
+            double rate, halfWidth;
+            UINT32 sets;
+            double secs = RunSampling( cfg, refs, mode, ratios[r], rate, halfWidth, sets );
+            double error = rate - fullRate;
+
+            printf( "  %-8s %6u %9u %14.0f %8.2fx %10.4f%% %8.4f%% %7.4f%%%s\n", modes[ mode ], ratios[r], sets,
+                    cfg.numRefs / secs, fullSecs / secs, 100.0 * rate, 100.0 * halfWidth, 100.0 * error,
+                    (fabs( error ) <= halfWidth) ? "" : "  (outside interval)" );
+        }
+    }
+
+    delete [] refs;
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: a 4-thread mix sharing the cache, interleaved round robin.      //
+// Thread 0 streams through lines it never touches again, so BRRIP suits it.  //
+// Threads 1-3 each reuse a working set of a fifth of the cache that slides   //
+// forward by a line every 64 accesses, plus some accesses to a larger        //
+// footprint; their new lines need the SRRIP insertion. DRRIP runs once with  //
+// one selector for all threads (the thread ids folded to 0, as before        //
+// TA-DRRIP) and once thread-aware.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+#define BENCH_MIX_THREADS 4
+
+static Access *MakeMix( const BENCH_CONFIG &cfg )
+{
+    Access *refs = new Access[ cfg.numRefs ];
+
+    unsigned long long seed  = 0x9e3779b97f4a7c15ULL;
+    unsigned long long lines = cfg.cacheSize / cfg.linesize;
+    unsigned long long hot   = lines / 5;
+    unsigned long long cold  = lines * 2;
+    unsigned long long seq   = 0;
+
+    // line numbers within a thread: the sliding working set, then the
+    // larger footprint from 2^30
+
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        unsigned long long r    = BenchRand( seed );
+        UINT32             tid  = i % BENCH_MIX_THREADS;
+        unsigned long long base = (unsigned long long)tid << 32;
+        unsigned long long line;
+
+        if( tid == 0 )            line = seq++;
+        else if( r % 100 < 85 )   line = i / 64 + (r >> 8) % hot;
+        else                      line = (1ULL << 30) + (r >> 8) % cold;
+
+        refs[i].tid        = tid;
+        refs[i].PC         = 0x400000 + tid * 0x1000;
+        refs[i].paddr      = (base + line) * cfg.linesize;
+        refs[i].accessType = ACCESS_LOAD;
+    }
+
+    return refs;
+}
+
+// Misses and final DRRIP winner per thread; with shared set, every access
+// is made as thread 0
+static double RunMix( const BENCH_CONFIG &cfg, const Access *refs, UINT32 policy, bool shared, COUNTER *misses,
+                      UINT32 *winners )
+{
+    CRC_CACHE cache( cfg.cacheSize, cfg.assoc, shared ? 1 : BENCH_MIX_THREADS, cfg.linesize, policy );
+
+    memset( misses, 0, BENCH_MIX_THREADS * sizeof(COUNTER) );
+
+    double start = BenchNow();
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        UINT32 tid = shared ? 0 : refs[i].tid;
+
+        if( !cache.LookupAndFillCache( tid, refs[i].PC, refs[i].paddr, refs[i].accessType ) ) misses[ refs[i].tid ]++;
+    }
+    double secs = BenchNow() - start;
+
+    CRC_SET_DUELING *duel = cache.ReplacementState()->Dueling();
+
+    for(UINT32 t=0; t<BENCH_MIX_THREADS; t++)
+    {
+        winners[t] = duel ? duel->Winner( shared ? 0 : t ) : 0;
+    }
+
+    return secs;
+}
+
+static int BenchMix( const BENCH_CONFIG &cfg )
+{
+    static const char *names[] = { "LRU", "DRRIP", "TA-DRRIP" };
+
+    Access *refs = MakeMix( cfg );
+    COUNTER misses[3][ BENCH_MIX_THREADS ];
+    UINT32  winners[3][ BENCH_MIX_THREADS ];
+    double  secs[3];
+
+    secs[0] = RunMix( cfg, refs, CRC_REPL_LRU, false, misses[0], winners[0] );
+    secs[1] = RunMix( cfg, refs, CRC_REPL_CONTESTANT, true, misses[1], winners[1] );
+    secs[2] = RunMix( cfg, refs, CRC_REPL_CONTESTANT, false, misses[2], winners[2] );
+
+    COUNTER perThread = cfg.numRefs / BENCH_MIX_THREADS;
+
+    printf( "  %-10s %10s %10s %10s %10s %14s %10s  %s\n", "policy", "t0 miss%", "t1 miss%", "t2 miss%", "t3 miss%",
+            "misses", "ns/acc", "winners" );
+
+    for(UINT32 p=0; p<3; p++)
+    {
+        COUNTER total = 0;
+
+        printf( "  %-10s", names[p] );
+        for(UINT32 t=0; t<BENCH_MIX_THREADS; t++)
+        {
+            printf( " %10.2f", 100.0 * misses[p][t] / perThread );
+            total += misses[p][t];
+        }
+        printf( " %14llu %10.2f ", total, secs[p] * 1e9 / cfg.numRefs );
+
+        // LRU has none; the shared DRRIP selector is the same for all
+        for(UINT32 t=0; p>0 && t<BENCH_MIX_THREADS; t++) printf( " %s", (winners[p][t] == CRC_DRRIP_SRRIP) ? "SRRIP" : "BRRIP" );
+        printf( "\n" );
+    }
+
+    delete [] refs;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Check: set dueling. Each candidate policy misses with its own probability, //
+// the best one placed differently in every round, and after a warm-up the    //
+// tournament must pick it. Then sweeps with strides that match the original  //
+// DRRIP layout count how many leader sets of each policy they touch: the     //
+// original leaders (every 33rd and every 31st set) give one policy all of    //
+// them, hashed leaders split them.                                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static UINT32 LegacyDrripLeader( UINT32 setIndex )
+{
+    if( ((setIndex % 33) == 0) && (setIndex < 32 * 33) ) return 1;
+    if( ((setIndex % 31) == 0) && (setIndex > 0) && (setIndex <= 31 * 32) ) return 2;
+    return 0;
+}
+
+static int BenchDuel( const BENCH_CONFIG &cfg )
+{
+    UINT32             numsets = cfg.cacheSize / (cfg.linesize * cfg.assoc);
+    unsigned long long seed    = 0x2545f4914f6cdd1dULL;
+    int                status  = 0;
+
+    printf( "  %-9s %-6s %12s %10s %8s\n", "policies", "best", "leader miss", "winner", "" );
+
+    for(UINT32 policies=2; policies<=6; policies++)
+    {
+        for(UINT32 best=0; best<policies; best++)
+        {
+            CRC_SET_DUELING duel( numsets, policies, 1, CRC_DRRIP_LEADERS, CRC_DRRIP_COUNTER_BITS );
+            COUNTER         leaderMisses = 0;
+
+            for(COUNTER i=0; i<cfg.numRefs; i++)
+            {
+                UINT32 setIndex = BenchRand( seed ) % numsets;
+                UINT32 policy   = duel.Policy( setIndex, 0 );
+
+                // the best policy misses 30% of the time, the others 40-60%
+                UINT32 missPct = (policy == best) ? 30 : 40 + (policy * 7) % 21;
+
+                if( BenchRand( seed ) % 100 < missPct )
+                {
+                    leaderMisses += duel.IsLeader( setIndex );
+                    duel.Fill( setIndex, 0, policy );
+                }
+            }
+
+            bool ok = duel.Winner( 0 ) == best;
+
+            printf( "  %-9u %-6u %12llu %10u %8s\n", policies, best, leaderMisses, duel.Winner( 0 ), ok ? "" : "WRONG" );
+
+            if( !ok ) status = 1;
+        }
+    }
+
+    CRC_SET_DUELING duel( numsets, 2, 1, CRC_DRRIP_LEADERS, CRC_DRRIP_COUNTER_BITS );
+
+    printf( "\n  %-7s %22s %22s\n", "stride", "% 33/% 31 SRRIP BRRIP", "hashed SRRIP BRRIP" );
+
+    for(UINT32 stride=31; stride<=66; stride+=stride == 33 ? 33 : 2)
+    {
+        UINT32 legacy[3] = { 0, 0, 0 };
+        UINT32 hashed[3] = { 0, 0, 0 };
+
+        for(UINT32 setIndex=0; setIndex<numsets; setIndex+=stride)
+        {
+            legacy[ LegacyDrripLeader( setIndex ) ]++;
+            if( duel.IsLeader( setIndex ) ) hashed[ 1 + duel.Policy( setIndex, 0 ) ]++;
+        }
+
+        printf( "  %-7u %16u %5u %16u %5u\n", stride, legacy[1], legacy[2], hashed[1], hashed[2] );
+    }
+
+    if( status ) printf( "ERROR: a tournament picked the wrong policy\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Benchmark: every policy but OPT with and without its probes sampled 64     //
+// times over the stream (-LLCrepl is ignored). The probes must not change    //
+// a single miss, and their totals must add up: every miss either bypasses,   //
+// fills an invalid way or evicts a line, every eviction has a count of hits  //
+// before it, and every fill an insertion position.                           //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static double RunInstrument( const BENCH_CONFIG &cfg, const Access *refs, UINT32 policy, bool probes,
+                             COUNTER &misses, const char *&error )
+{
+    CRC_CACHE cache( cfg.cacheSize, cfg.assoc, 1, cfg.linesize, policy );
+
+    if( probes ) cache.EnableInstrumentation( (cfg.numRefs >= 64) ? cfg.numRefs / 64 : 1 );
+
+    double start = BenchNow();
+    for(COUNTER i=0; i<cfg.numRefs; i++)
+    {
+        cache.LookupAndFillCache( refs[i].tid, refs[i].PC, refs[i].paddr, refs[i].accessType );
+    }
+    double secs = BenchNow() - start;
+
+    misses = cache.ThreadDemandMissStats( 0 );
+    error  = NULL;
+
+    if( !probes ) return secs;
+
+    CRC_INSTRUMENTATION *inst = cache.ReplacementState()->Instrumentation();
+
+    long long accesses  = inst->Value( inst->Find( "accesses" ) );
+    long long missed    = inst->Value( inst->Find( "misses" ) );
+    long long bypasses  = inst->Value( inst->Find( "bypasses" ) );
+    long long evictions = inst->Value( inst->Find( "evictions" ) );
+    long long counted[3] = { 0, 0, 0 };
+    INT32     histograms[3];
+
+    histograms[0] = inst->Find( "hits_before_eviction" );
+    histograms[1] = inst->Find( "insertion_rrpv" );
+    histograms[2] = inst->Find( "eviction_rrpv" );
+
+    if( histograms[1] == -1 ) histograms[1] = inst->Find( "insertion_stack_position" );
+    if( histograms[2] == -1 ) histograms[2] = inst->Find( "eviction_stack_position" );
+
+    for(UINT32 h=0; h<3; h++)
+    {
+        for(UINT32 b=0; histograms[h] != -1 && b<inst->Bins( histograms[h] ); b++) counted[h] += inst->Value( histograms[h], b );
+    }
+
+    if( accesses != (long long)cfg.numRefs || missed != (long long)misses ) error = "accesses or misses";
+    else if( bypasses + evictions + (long long)cache.ValidLineCount() != missed ) error = "bypasses and evictions";
+    else if( counted[0] != evictions ) error = "hits before eviction";
+    else if( histograms[1] != -1 && counted[1] != missed - bypasses ) error = "insertion positions";
+    else if( histograms[2] != -1 && counted[2] != evictions ) error = "eviction positions";
+    else if( inst->Samples() != cfg.numRefs / inst->Interval() ) error = "samples";
+
+    return secs;
+}
+
+static int BenchInstrument( const BENCH_CONFIG &cfg )
+{
+    static const char *names[] = { "LRU", "Random", "DRRIP", "SHiP", "Hawkeye", "OPT", "OPT-b", "TreePLRU", "NRU", "EAF",
+                                   "SDBP", "SDBP-b", "MPP", "ARC" };
+
+    if( !CRC_INSTRUMENT_BUILT )
+    {
+        printf( "ERROR: built without CRC_INSTRUMENT (make CMDLINE=-DCRC_INSTRUMENT=1)\n" );
+        return 1;
+    }
+
+    Access *refs   = MakeStream( cfg );
+    int     status = 0;
+
+    printf( "  %-8s %12s %12s %9s %14s\n", "policy", "plain ns/acc", "probes ns/acc", "overhead", "misses" );
+
+    for(UINT32 policy=CRC_REPL_LRU; policy<=CRC_REPL_ARC; policy++)
+    {
+        if( policy == CRC_REPL_OPT || policy == CRC_REPL_OPT_BYPASS ) continue;
+
+        COUNTER     plainMisses, probeMisses;
+        const char *error;
+        double      plainSecs = RunInstrument( cfg, refs, policy, false, plainMisses, error );
+        double      probeSecs = RunInstrument( cfg, refs, policy, true, probeMisses, error );
+
+        if( !error && plainMisses != probeMisses ) error = "misses changed";
+
+        printf( "  %-8s %12.2f %12.2f %8.1f%% %14llu%s%s\n", names[ policy ], plainSecs * 1e9 / cfg.numRefs,
+                probeSecs * 1e9 / cfg.numRefs, 100.0 * (probeSecs - plainSecs) / plainSecs, probeMisses,
+                error ? "  MISMATCH: " : "", error ? error : "" );
+
+        if( error ) status = 1;
+    }
+
+    delete [] refs;
+
+    if( status ) printf( "ERROR: the probes disagree with the cache\n" );
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Not a benchmark: dump the synthetic stream as a trace for the other tools  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int GenTrace( const BENCH_CONFIG &cfg )
+{
+    Access *refs = MakeStream( cfg );
+
+    CRC_TRACE_WRITER trace( cfg.tracePath );
+    trace.Write( refs, cfg.numRefs );
+    bool ok = trace.Close();
+
+    delete [] refs;
+
+    if( !ok )
+    {
+        printf( "ERROR: cannot write %s\n", cfg.tracePath );
+        return 1;
+    }
+
+    printf( "  wrote %llu accesses to %s\n", cfg.numRefs, cfg.tracePath );
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Command line handling                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static void Usage()
+{
+    fprintf( stderr, "usage: crc_bench <benchmark> [-cache UL3:size_KB:line:assoc] [-LLCrepl policy] [-n accesses] [-workers max] [-o trace_file]\n" );
+    fprintf( stderr, "benchmarks:\n" );
+    fprintf( stderr, "  tagstore   original LINE_STATE** layout vs the flat tag store\n" );
+    fprintf( stderr, "  lookup     tag match kernels on 4-, 8-, 16- and 32-way sets\n" );
+    fprintf( stderr, "  batch      LookupAndFillCache per access vs LookupAndFillBatch\n" );
+    fprintf( stderr, "  policy     generic vs policy-specialized access path for every policy but OPT\n" );
+    fprintf( stderr, "  lru        packed true LRU vs the original stack positions, 4 to 64 ways\n" );
+    fprintf( stderr, "  recency    tree-PLRU and NRU vs true LRU at 2 to 64 ways: speed and miss rate\n" );
+    fprintf( stderr, "  rrip       one-pass RRIP victim search vs the original aging loop\n" );
+    fprintf( stderr, "  parallel   set-sharded engine scaling and miss rate deviation\n" );
+    fprintf( stderr, "  sampling   set sampling speedup and miss rate estimate vs the full cache\n" );
+    fprintf( stderr, "  mix        4-thread mix with a streaming thread: shared vs thread-aware DRRIP selectors\n" );
+    fprintf( stderr, "  duel       set dueling tournament of 2-6 policies, and leader sets hit by strided sweeps\n" );
+    fprintf( stderr, "  instrument replacement policy probe cost and totals, every policy but OPT (CRC_INSTRUMENT builds)\n" );
+    fprintf( stderr, "  gentrace   write the synthetic stream to a trace file (-o file)\n" );
+    exit( 1 );
+}
+
+int main( int argc, char **argv )
+{
+    BENCH_CONFIG cfg;
+
+    cfg.cacheSize = 1024 * 1024;
+    cfg.linesize  = 64;
+    cfg.assoc     = 16;
+    cfg.policy    = CRC_REPL_LRU;
+    cfg.numRefs   = 20000000;
+
+    long cpus      = sysconf( _SC_NPROCESSORS_ONLN );
+    cfg.maxWorkers = (cpus > 2) ? cpus : 2;
+    cfg.tracePath  = "crc_bench.trace";
+
+    if( argc < 2 ) Usage();
+
+    for(int i=2; i<argc; i++)
+    {
+        if( !strcmp( argv[i], "-cache" ) && i+1 < argc )
+        {
+            UINT32 kb, line, ways;
+            if( sscanf( argv[++i], "UL3:%u:%u:%u", &kb, &line, &ways ) != 3 ) Usage();
+            cfg.cacheSize = kb * 1024;
+            cfg.linesize  = line;
+            cfg.assoc     = ways;
+        }
+        else if( !strcmp( argv[i], "-LLCrepl" ) && i+1 < argc )
+        {
+            if( sscanf( argv[++i], "%u", &cfg.policy ) != 1 || cfg.policy >= CRC_REPL_POLICIES ) Usage();
+        }
+        else if( !strcmp( argv[i], "-n" ) && i+1 < argc )       cfg.numRefs = strtoull( argv[++i], NULL, 10 );
+        else if( !strcmp( argv[i], "-workers" ) && i+1 < argc ) cfg.maxWorkers = atoi( argv[++i] );
+        else if( !strcmp( argv[i], "-o" ) && i+1 < argc )       cfg.tracePath  = argv[++i];
+        else Usage();
+    }
+
+    printf( "%s: UL3:%u:%u:%u, LLCrepl %u, %llu accesses\n", argv[1],
+            cfg.cacheSize / 1024, cfg.linesize, cfg.assoc, cfg.policy, cfg.numRefs );
+
+    if( !strcmp( argv[1], "tagstore" ) ) return BenchTagStore( cfg );
+    if( !strcmp( argv[1], "lookup" ) )   return BenchLookup( cfg );
+    if( !strcmp( argv[1], "batch" ) )    return BenchBatch( cfg );
+    if( !strcmp( argv[1], "policy" ) )   return BenchPolicy( cfg );
+    if( !strcmp( argv[1], "lru" ) )      return BenchLru( cfg );
+    if( !strcmp( argv[1], "recency" ) )  return BenchRecency( cfg );
+    if( !strcmp( argv[1], "rrip" ) )     return BenchRrip( cfg );
+    if( !strcmp( argv[1], "parallel" ) ) return BenchParallel( cfg );
+    if( !strcmp( argv[1], "sampling" ) ) return BenchSampling( cfg );
+    if( !strcmp( argv[1], "mix" ) )      return BenchMix( cfg );
+    if( !strcmp( argv[1], "duel" ) )     return BenchDuel( cfg );
+    if( !strcmp( argv[1], "instrument" ) ) return BenchInstrument( cfg );
+    if( !strcmp( argv[1], "gentrace" ) ) return GenTrace( cfg );
+
+    Usage();
+    return 1;
+}
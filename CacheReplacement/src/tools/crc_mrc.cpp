@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// crc_mrc: LRU miss ratio curves of a trace in a single pass.                //
+//                                                                            //
+// The set count comes from -cache (size / (line * assoc)); the set-          //
+// associative curve covers 1..-maxways ways at that set count and the fully  //
+// associative curve every power of two capacity up to the footprint.         //
+// Writebacks are skipped (see crc_stack_dist.h).                             //
+//                                                                            //
+// With -check ways the trace is replayed a second time through a CRC_CACHE   //
+// with CRC_REPL_LRU and the given associativity, and its hit count must      //
+// equal the curve's.                                                         //
+//                                                                            //
+// -sample rate and/or -samplemax lines switch to SHARDS sampled curves       //
+// (crc_shards.h) at a fixed rate or in fixed memory. Only the set-           //
+// associative curve comes with a 95% confidence interval. -check then shows  //
+// where CRC_CACHE falls against it and fails only outside the 99% interval,  //
+// since a 95% interval misses one run in twenty by design. -exact runs the   //
+// exact engine in the same pass and reports the error of both sampled        //
+// curves, the only measure of the fully associative one.                     //
+//                                                                            //
+// Usage: crc_mrc -trace file [-cache UL3:size_KB:line:assoc]                 //
+//                [-maxways ways] [-o curve_file] [-check ways]               //
+//                [-sample rate] [-samplemax lines] [-exact]                  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <time.h>
+#include "crc_cache.h"
+#include "crc_trace.h"
+#include "crc_stack_dist.h"
+#include "crc_shards.h"
+
+#define MRC_READ_SIZE 4096
+
+static double MrcNow()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void Usage()
+{
+    fprintf( stderr, "usage: crc_mrc -trace file [-cache UL3:size_KB:line:assoc] [-maxways ways] [-o curve_file] [-check ways]\n"
+                     "               [-sample rate] [-samplemax lines] [-exact]\n" );
+    exit( 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Replay the trace, minus its writebacks, through a numsets x ways LRU       //
+// CRC_CACHE and return its hit count                                         //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static COUNTER CheckHits( CRC_TRACE_READER &trace, UINT32 numsets, UINT32 linesize, UINT32 ways )
+{
+    CRC_CACHE cache( numsets * ways * linesize, ways, trace.Threads(), linesize, CRC_REPL_LRU );
+    Access    buf[ MRC_READ_SIZE ];
+    COUNTER   hits = 0;
+    size_t    n;
+
+    trace.Rewind();
+
+    while( (n = trace.Read( buf, MRC_READ_SIZE )) > 0 )
+    {
+        for(size_t i=0; i<n; i++)
+        {
+            if( buf[i].accessType == ACCESS_WRITEBACK ) continue;
+
+            hits += cache.LookupAndFillCache( buf[i].tid, buf[i].PC, buf[i].paddr, buf[i].accessType );
+        }
+    }
+
+    return hits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Exact curves                                                               //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int RunExact( CRC_TRACE_READER &trace, FILE *out, UINT32 numsets, UINT32 linesize,
+                     UINT32 maxWays, UINT32 checkWays )
+{
+    CRC_STACK_DISTANCE mrc( numsets, linesize, maxWays );
+    Access buf[ MRC_READ_SIZE ];
+    size_t n;
+
+    double start = MrcNow();
+    while( (n = trace.Read( buf, MRC_READ_SIZE )) > 0 )
+    {
+        for(size_t i=0; i<n; i++) mrc.Reference( buf[i] );
+    }
+    double secs = MrcNow() - start;
+
+    fprintf( stderr, "crc_mrc: %llu accesses, %llu distinct lines in %.2f s (%.0f accesses/sec)\n",
+             mrc.Accesses(), mrc.DistinctLines(), secs, (mrc.Accesses() + mrc.Writebacks()) / secs );
+
+    mrc.WriteCurve( out );
+
+    if( checkWays )
+    {
+        COUNTER expected = mrc.SetAssocHits( checkWays );
+        COUNTER actual   = CheckHits( trace, numsets, linesize, checkWays );
+
+        fprintf( stderr, "crc_mrc: check %u sets x %u ways: curve %llu hits, CRC_CACHE %llu hits: %s\n",
+                 numsets, checkWays, expected, actual, (expected == actual) ? "ok" : "MISMATCH" );
+
+        if( expected != actual ) return 1;
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// SHARDS sampled curves, optionally measured against the exact ones          //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+static int RunSampled( CRC_TRACE_READER &trace, FILE *out, UINT32 numsets, UINT32 linesize,
+                       UINT32 maxWays, UINT32 checkWays, double rate, size_t maxLines, bool exact )
+{
+    CRC_SHARDS          shards( numsets, linesize, maxWays, rate, maxLines );
+    CRC_STACK_DISTANCE *mrc = exact ? new CRC_STACK_DISTANCE( numsets, linesize, maxWays ) : NULL;
+    Access buf[ MRC_READ_SIZE ];
+    size_t n;
+
+    double start = MrcNow();
+    while( (n = trace.Read( buf, MRC_READ_SIZE )) > 0 )
+    {
+        for(size_t i=0; i<n; i++) shards.Reference( buf[i] );
+        if( mrc ) for(size_t i=0; i<n; i++) mrc->Reference( buf[i] );
+    }
+    double secs = MrcNow() - start;
+
+    fprintf( stderr, "crc_mrc: %llu accesses, rate %g, %llu sampled accesses, %llu tracked lines in %.2f s (%.0f accesses/sec)\n",
+             shards.Accesses(), shards.Rate(), shards.SampledAccesses(), (COUNTER)shards.TrackedLines(), secs,
+             (shards.Accesses() + shards.Writebacks()) / secs );
+
+    // print the fully associative curve up to twice the estimated footprint
+    double footprint = shards.TrackedLines() / shards.Rate();
+    UINT32 maxLog2   = 1;
+    while( maxLog2 < 63 && (double)(1ULL << (maxLog2 - 1)) < footprint ) maxLog2++;
+
+    shards.WriteCurve( out, maxLog2 );
+
+    int status = 0;
+
+    if( mrc )
+    {
+        double accesses = mrc->Accesses();
+        double faMax = 0, faSum = 0, saMax = 0, saSum = 0;
+
+        for(UINT32 k=0; k<=maxLog2; k++)
+        {
+            double err = fabs( shards.FullyAssocMissRatio( k ) - (1.0 - mrc->FullyAssocHits( 1ULL << k ) / accesses) );
+            faSum += err;
+            if( err > faMax ) faMax = err;
+        }
+
+        for(UINT32 ways=1; ways<=maxWays; ways++)
+        {
+            double halfWidth;
+            double err = fabs( shards.SetAssocMissRatio( ways, halfWidth ) - (1.0 - mrc->SetAssocHits( ways ) / accesses) );
+            saSum += err;
+            if( err > saMax ) saMax = err;
+        }
+
+        fprintf( stderr, "crc_mrc: error vs exact: fully associative mean %.6f max %.6f, set-associative mean %.6f max %.6f\n",
+                 faSum / (maxLog2 + 1), faMax, saSum / maxWays, saMax );
+
+        delete mrc;
+    }
+
+    if( checkWays )
+    {
+        double  halfWidth, halfWidth99;
+        double  estimate = shards.SetAssocMissRatio( checkWays, halfWidth );
+        COUNTER hits     = CheckHits( trace, numsets, linesize, checkWays );
+        double  actual   = 1.0 - (double)hits / shards.Accesses();
+        double  error    = fabs( estimate - actual );
+
+        shards.SetAssocMissRatio( checkWays, halfWidth99, CRC_SHARDS_Z99 );
+
+        fprintf( stderr, "crc_mrc: check %u sets x %u ways: estimate %.6f +- %.6f, CRC_CACHE %.6f: %s\n",
+                 numsets, checkWays, estimate, halfWidth, actual,
+                 (error <= halfWidth) ? "within 95% interval" : ((error <= halfWidth99) ? "within 99% interval" : "OUTSIDE 99% interval") );
+
+        if( error > halfWidth99 ) status = 1;
+    }
+
+    return status;
+}
+
+int main( int argc, char **argv )
+{
+    const char *tracePath = NULL;
+    const char *outPath   = NULL;
+    UINT32      cacheSize = 1024 * 1024;
+    UINT32      linesize  = 64;
+    UINT32      assoc     = 16;
+    UINT32      maxWays   = 0;
+    UINT32      checkWays = 0;
+    double      rate      = 0;
+    size_t      maxLines  = 0;
+    bool        exact     = false;
+
+    for(int i=1; i<argc; i++)
+    {
+        if( !strcmp( argv[i], "-trace" ) && i+1 < argc ) tracePath = argv[++i];
+        else if( !strcmp( argv[i], "-cache" ) && i+1 < argc )
+        {
+            UINT32 kb, line, ways;
+            if( sscanf( argv[++i], "UL3:%u:%u:%u", &kb, &line, &ways ) != 3 ) Usage();
+            cacheSize = kb * 1024;
+            linesize  = line;
+            assoc     = ways;
+        }
+        else if( !strcmp( argv[i], "-maxways" ) && i+1 < argc ) maxWays   = atoi( argv[++i] );
+        else if( !strcmp( argv[i], "-o" ) && i+1 < argc )       outPath   = argv[++i];
+        else if( !strcmp( argv[i], "-check" ) && i+1 < argc )   checkWays = atoi( argv[++i] );
+        else if( !strcmp( argv[i], "-sample" ) && i+1 < argc )  rate      = atof( argv[++i] );
+        else if( !strcmp( argv[i], "-samplemax" ) && i+1 < argc ) maxLines = strtoull( argv[++i], NULL, 10 );
+        else if( !strcmp( argv[i], "-exact" ) )                 exact     = true;
+        else Usage();
+    }
+
+    if( !tracePath ) Usage();
+    if( !maxWays ) maxWays = 2 * assoc;
+
+    UINT32 numsets = cacheSize / (linesize * assoc);
+
+    if( checkWays > maxWays || checkWays > 64 )
+    {
+        fprintf( stderr, "crc_mrc: -check ways must be at most -maxways and 64\n" );
+        return 1;
+    }
+
+    CRC_TRACE_READER trace( tracePath );
+
+    if( !trace.Ok() )
+    {
+        fprintf( stderr, "crc_mrc: cannot read trace %s\n", tracePath );
+        return 1;
+    }
+
+    FILE *out = outPath ? fopen( outPath, "w" ) : stdout;
+
+    if( !out )
+    {
+        fprintf( stderr, "crc_mrc: cannot write %s\n", outPath );
+        return 1;
+    }
+
+    int status;
+
+    if( rate > 0 || maxLines )
+    {
+        status = RunSampled( trace, out, numsets, linesize, maxWays, checkWays,
+                             (rate > 0) ? rate : 1.0, maxLines, exact );
+    }
+    else
+    {
+        status = RunExact( trace, out, numsets, linesize, maxWays, checkWays );
+    }
+
+    if( outPath ) fclose( out );
+
+    return status;
+}
@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// llcsim: standalone trace-driven LLC simulator.                             //
+//                                                                            //
+// Replays a binary trace (layout in crc_trace.h) through a CRC_CACHE and     //
+// prints the same statistics as the CMPsim binaries, followed by the         //
+// throughput of the simulator itself. The trace is memory mapped and read    //
+// front to back, so it is never copied. A trace ending in .gz is inflated    //
+// on a second thread instead (crc_gz_trace.h), and the report adds the       //
+// throughput and stall time of both pipeline stages. The cache options       //
+// follow CMPsim (bin/README); traces can be made with crc_bench gentrace.    //
+//                                                                            //
+// Usage: llcsim -t trace_file [-threads n] [-cache UL3:size_KB:line:assoc]   //
+//               [-LLCrepl policy] [-o stats_file] [-n accesses]              //
+//               [-batch] [-sample stride:k|hash:k]                           //
+//               [-ship shct_bits:signature_bits] [-opt index_file]           //
+//               [-duel leaders:counter_bits[:interval]]                      //
+//               [-inst interval [-instjson file] [-instseries file]]         //
+//                                                                            //
+//   -batch     use LookupAndFillBatch instead of one LookupAndFillCache      //
+//              call per access                                               //
+//   -sample    simulate only 1 in k sets (see crc_set_sample.h)              //
+//   -ship      SHiP (-LLCrepl 3) table sizes: 2^shct_bits SHCT entries,      //
+//              signature_bits-wide PC signatures (default 14:14)             //
+//   -duel      DRRIP (-LLCrepl 2) set dueling: leader sets per policy and    //
+//              thread, selector width (default 32:10), and if interval is    //
+//              given a trace of the winners every interval fills             //
+//   -opt       next-use index for Belady OPT (-LLCrepl 5, or 6 with bypass). //
+//              A missing index, or one for another length or line size, is   //
+//              first built from the trace in a separate pass (see            //
+//              crc_next_use.h); keep one file per trace                      //
+//   -inst      sample the replacement policy probes every interval accesses  //
+//              into the report (crc_instrument.h), and write them as JSON    //
+//              and as a binary series; needs a build with CRC_INSTRUMENT     //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <time.h>
+#include "crc_cache.h"
+#include "crc_trace.h"
+#include "crc_gz_trace.h"
+#include "crc_next_use.h"
+
+#define LLCSIM_BATCH_SIZE 4096
+
+static double LlcsimNow()
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Replay a run of records, one call per access or as batches. The cache
+// indexes its statistics by thread and access type, so a corrupt record
+// with a thread the cache does not have or an unknown access type stops the
+// run there; returns the number of records replayed.
+static COUNTER Simulate( CRC_CACHE &cache, UINT32 threads, const Access *refs, COUNTER n, bool batch )
+{
+    for(COUNTER i=0; i<n; i+=LLCSIM_BATCH_SIZE)
+    {
+        size_t run  = (n - i < LLCSIM_BATCH_SIZE) ? n - i : LLCSIM_BATCH_SIZE;
+        size_t good = 0;
+
+        while( good < run && refs[i + good].tid < threads && refs[i + good].accessType < ACCESS_MAX ) good++;
+
+        if( batch )
+        {
+            cache.LookupAndFillBatch( refs + i, good, NULL );
+        }
+        else
+        {
+            for(size_t j=i; j<i + good; j++)
+            {
+                cache.LookupAndFillCache( refs[j].tid, refs[j].PC, refs[j].paddr, refs[j].accessType );
+            }
+        }
+
+        if( good < run ) return i + good;
+    }
+
+    return n;
+}
+
+static bool IsGzip( const char *path )
+{
+    size_t len = strlen( path );
+    return len > 3 && !strcmp( path + len - 3, ".gz" );
+}
+
+// First pass of OPT: write the next-use index of the first numRefs accesses
+static bool BuildNextUse( const char *indexPath, const char *tracePath, CRC_TRACE_MAP *mapped, COUNTER numRefs, UINT32 linesize,
+                          COUNTER traceBytes, unsigned long long traceHash )
+{
+    CRC_NEXT_USE_BUILDER builder( indexPath, numRefs, linesize, traceBytes, traceHash );
+
+    if( mapped )
+    {
+        builder.Add( mapped->Records(), numRefs );
+    }
+    else
+    {
+        CRC_GZ_TRACE_READER reader( tracePath );
+        const Access       *refs;
+        COUNTER             done = 0;
+        size_t              n;
+
+        while( done < numRefs && (n = reader.Next( refs )) > 0 )
+        {
+            if( n > numRefs - done ) n = numRefs - done;
+
+            builder.Add( refs, n );
+            done += n;
+        }
+    }
+
+    return builder.Finish();
+}
+
+// Length of a compressed trace, which only a full pass can tell; a corrupt
+// or truncated trace ends the run
+static COUNTER CountGzRecords( const char *tracePath, COUNTER maxRefs )
+{
+    CRC_GZ_TRACE_READER reader( tracePath );
+    const Access       *refs;
+    COUNTER             count = 0;
+    size_t              n;
+
+    while( (!maxRefs || count < maxRefs) && (n = reader.Next( refs )) > 0 ) count += n;
+
+    if( reader.ReadError() )
+    {
+        fprintf( stderr, "llcsim: trace %s is corrupt or truncated after %llu of %llu records\n", tracePath, count, reader.NumRecords() );
+        exit( 1 );
+    }
+
+    return (maxRefs && count > maxRefs) ? maxRefs : count;
+}
+
+static void Usage()
+{
+    fprintf( stderr, "usage: llcsim -t trace_file [-threads n] [-cache UL3:size_KB:line:assoc] [-LLCrepl policy]\n"
+                     "              [-o stats_file] [-n accesses] [-batch] [-sample stride:k|hash:k]\n"
+                     "              [-ship shct_bits:signature_bits] [-opt index_file]\n"
+                     "              [-duel leaders:counter_bits[:interval]]\n"
+                     "              [-inst interval [-instjson file] [-instseries file]]\n" );
+    exit( 1 );
+}
+
+int main( int argc, char **argv )
+{
+    const char *tracePath  = NULL;
+    const char *outPath    = NULL;
+    UINT32      threads    = 0;
+    UINT32      cacheSize  = 1024 * 1024;
+    UINT32      linesize   = 64;
+    UINT32      assoc      = 16;
+    UINT32      policy     = CRC_REPL_LRU;
+    COUNTER     maxRefs    = 0;
+    bool        batch      = false;
+    UINT32      sampleMode = CRC_SAMPLE_NONE;
+    UINT32      sampleK    = 1;
+    UINT32      shctBits   = CRC_SHIP_SHCT_BITS;
+    UINT32      sigBits    = CRC_SHIP_SIGNATURE_BITS;
+    const char *optPath    = NULL;
+    UINT32      duelLeaders  = CRC_DRRIP_LEADERS;
+    UINT32      duelBits     = CRC_DRRIP_COUNTER_BITS;
+    COUNTER     duelInterval = 0;
+    COUNTER     instInterval = 0;
+    const char *instJson     = NULL;
+    const char *instSeries   = NULL;
+
+    for(int i=1; i<argc; i++)
+    {
+        if( !strcmp( argv[i], "-t" ) && i+1 < argc )             tracePath = argv[++i];
+        else if( !strcmp( argv[i], "-threads" ) && i+1 < argc )  threads   = atoi( argv[++i] );
+        else if( !strcmp( argv[i], "-cache" ) && i+1 < argc )
+        {
+            UINT32 kb, line, ways;
+            if( sscanf( argv[++i], "UL3:%u:%u:%u", &kb, &line, &ways ) != 3 ) Usage();
+            cacheSize = kb * 1024;
+            linesize  = line;
+            assoc     = ways;
+        }
+        else if( !strcmp( argv[i], "-LLCrepl" ) && i+1 < argc )
+        {
+            if( sscanf( argv[++i], "%u", &policy ) != 1 || policy >= CRC_REPL_POLICIES ) Usage();
+        }
+        else if( !strcmp( argv[i], "-o" ) && i+1 < argc )       outPath   = argv[++i];
+        else if( !strcmp( argv[i], "-n" ) && i+1 < argc )       maxRefs   = strtoull( argv[++i], NULL, 10 );
+        else if( !strcmp( argv[i], "-batch" ) )                 batch     = true;
+        else if( !strcmp( argv[i], "-sample" ) && i+1 < argc )
+        {
+            ++i;
+            if( sscanf( argv[i], "stride:%u", &sampleK ) == 1 )    sampleMode = CRC_SAMPLE_STRIDE;
+            else if( sscanf( argv[i], "hash:%u", &sampleK ) == 1 ) sampleMode = CRC_SAMPLE_HASH;
+            else Usage();
+            if( sampleK < 1 ) Usage();
+        }
+        else if( !strcmp( argv[i], "-ship" ) && i+1 < argc )
+        {
+            if( sscanf( argv[++i], "%u:%u", &shctBits, &sigBits ) != 2 ) Usage();
+            if( shctBits < 1 || shctBits > CRC_SHIP_MAX_BITS || sigBits < 1 || sigBits > CRC_SHIP_MAX_BITS ) Usage();
+        }
+        else if( !strcmp( argv[i], "-duel" ) && i+1 < argc )
+        {
+            if( sscanf( argv[++i], "%u:%u:%llu", &duelLeaders, &duelBits, &duelInterval ) < 2 ) Usage();
+            if( duelLeaders < 1 || duelBits < 1 || duelBits > CRC_DUEL_MAX_BITS ) Usage();
+        }
+        else if( !strcmp( argv[i], "-opt" ) && i+1 < argc )     optPath   = argv[++i];
+        else if( !strcmp( argv[i], "-inst" ) && i+1 < argc )
+        {
+            instInterval = strtoull( argv[++i], NULL, 10 );
+            if( instInterval < 1 ) Usage();
+        }
+        else if( !strcmp( argv[i], "-instjson" ) && i+1 < argc )   instJson   = argv[++i];
+        else if( !strcmp( argv[i], "-instseries" ) && i+1 < argc ) instSeries = argv[++i];
+        else Usage();
+    }
+
+    if( !tracePath ) Usage();
+
+    bool opt = (policy == CRC_REPL_OPT || policy == CRC_REPL_OPT_BYPASS);
+
+    if( opt != (optPath != NULL) )
+    {
+        fprintf( stderr, "llcsim: -LLCrepl %u and %u need -opt, and -opt needs one of them\n", CRC_REPL_OPT, CRC_REPL_OPT_BYPASS );
+        return 1;
+    }
+
+    // the index is for every access, not for those of the sampled sets
+    if( opt && sampleMode != CRC_SAMPLE_NONE )
+    {
+        fprintf( stderr, "llcsim: OPT cannot be combined with -sample\n" );
+        return 1;
+    }
+
+    if( (instJson || instSeries) && !instInterval ) Usage();
+
+    if( instInterval && !CRC_INSTRUMENT_BUILT )
+    {
+        fprintf( stderr, "llcsim: -inst needs a build with CRC_INSTRUMENT (make CMDLINE=-DCRC_INSTRUMENT=1)\n" );
+        return 1;
+    }
+
+    CRC_TRACE_MAP       *mapped = NULL;
+    CRC_GZ_TRACE_READER *gz     = NULL;
+    UINT32               traceThreads;
+
+    if( IsGzip( tracePath ) )
+    {
+        gz = new CRC_GZ_TRACE_READER( tracePath );
+        traceThreads = gz->Threads();
+    }
+    else
+    {
+        mapped = new CRC_TRACE_MAP( tracePath );
+        traceThreads = mapped->Threads();
+    }
+
+    if( mapped && mapped->PresentRecords() < mapped->NumRecords() )
+    {
+        fprintf( stderr, "llcsim: trace %s is corrupt or truncated after %llu of %llu records\n", tracePath, mapped->PresentRecords(), mapped->NumRecords() );
+        return 1;
+    }
+
+    if( !(gz ? gz->Ok() : mapped->Ok()) )
+    {
+        fprintf( stderr, "llcsim: cannot read trace %s\n", tracePath );
+        return 1;
+    }
+
+    if( !threads ) threads = traceThreads ? traceThreads : 1;
+
+    if( threads < traceThreads )
+    {
+        fprintf( stderr, "llcsim: trace has %u threads, -threads %u is too few\n", traceThreads, threads );
+        return 1;
+    }
+
+    CRC_CACHE cache( cacheSize, assoc, threads, linesize, policy );
+    cache.ConfigureSHiP( shctBits, sigBits );
+    cache.ConfigureDueling( duelLeaders, duelBits, duelInterval );
+    cache.SetSampling( sampleMode, sampleK );
+    if( instInterval ) cache.EnableInstrumentation( instInterval );
+
+    CRC_NEXT_USE_MAP *nextUse = NULL;
+
+    if( opt )
+    {
+        COUNTER            optRefs;
+        COUNTER            traceBytes;
+        unsigned long long traceHash;
+
+        if( gz ) optRefs = CountGzRecords( tracePath, maxRefs );
+        else     optRefs = (maxRefs && maxRefs < mapped->NumRecords()) ? maxRefs : mapped->NumRecords();
+
+        if( !CRC_NextUseFingerprint( tracePath, traceBytes, traceHash ) )
+        {
+            fprintf( stderr, "llcsim: cannot read trace %s\n", tracePath );
+            return 1;
+        }
+
+        nextUse = new CRC_NEXT_USE_MAP( optPath );
+
+        // an index of another trace would replay OPT with wrong next uses
+        if( !nextUse->Ok() || nextUse->NumRecords() != optRefs || nextUse->LineSize() != linesize
+                || nextUse->TraceBytes() != traceBytes || nextUse->TraceHash() != traceHash )
+        {
+            delete nextUse;
+            nextUse = NULL;
+
+            double built = LlcsimNow();
+
+            if( BuildNextUse( optPath, tracePath, mapped, optRefs, linesize, traceBytes, traceHash ) ) nextUse = new CRC_NEXT_USE_MAP( optPath );
+
+            fprintf( stderr, "llcsim: built next-use index %s in %.3f s\n", optPath, LlcsimNow() - built );
+        }
+
+        if( !nextUse || !nextUse->Ok() || nextUse->NumRecords() != optRefs )
+        {
+            fprintf( stderr, "llcsim: cannot build next-use index %s\n", optPath );
+            return 1;
+        }
+
+        cache.SetNextUse( nextUse->Entries(), nextUse->NumRecords() );
+    }
+
+    COUNTER numRefs = 0;
+    bool    corrupt = false;
+    double  start   = LlcsimNow();
+
+    if( gz )
+    {
+        const Access *refs;
+        size_t        n;
+
+        while( (!maxRefs || numRefs < maxRefs) && (n = gz->Next( refs )) > 0 )
+        {
+            if( maxRefs && n > maxRefs - numRefs ) n = maxRefs - numRefs;
+
+            COUNTER done = Simulate( cache, threads, refs, n, batch );
+
+            numRefs += done;
+            if( done < n )
+            {
+                corrupt = true;
+                break;
+            }
+        }
+
+        corrupt = corrupt || gz->ReadError();
+    }
+    else
+    {
+        COUNTER n = mapped->NumRecords();
+        if( maxRefs && maxRefs < n ) n = maxRefs;
+
+        numRefs = Simulate( cache, threads, mapped->Records(), n, batch );
+        corrupt = numRefs < n;
+    }
+
+    if( corrupt )
+    {
+        fprintf( stderr, "llcsim: trace %s is corrupt or truncated after %llu of %llu records\n", tracePath, numRefs,
+                 gz ? gz->NumRecords() : mapped->NumRecords() );
+        return 1;
+    }
+
+    double secs = LlcsimNow() - start;
+
+    ofstream file;
+    if( outPath ) file.open( outPath );
+
+    ostream &out = outPath ? file : cout;
+
+    if( !out )
+    {
+        fprintf( stderr, "llcsim: cannot write %s\n", outPath );
+        return 1;
+    }
+
+    cache.PrintStats( out );
+
+    double rate = (secs > 0) ? numRefs / secs : 0;
+    double ns   = numRefs ? secs * 1e9 / numRefs : 0;
+
+    out<<endl;
+    out<<"=========================================================="<<endl;
+    out<<"================ Simulator Throughput ===================="<<endl;
+    out<<"=========================================================="<<endl;
+    out<<endl;
+    out<<"\tTrace:          "<<tracePath<<endl;
+    out<<"\tAccesses:       "<<numRefs<<endl;
+    out<<"\tMode:           "<<(batch ? "batch" : "per access")<<endl;
+    out<<"\tSimulation:     "<<secs<<" s"<<endl;
+    out<<"\tAccesses/sec:   "<<(COUNTER)rate<<endl;
+    out<<"\tns/access:      "<<ns<<endl;
+    out<<endl;
+
+    if( gz ) gz->PrintStats( out, secs );
+
+    CRC_INSTRUMENTATION *inst = cache.ReplacementState()->Instrumentation();
+
+    if( inst && instJson )
+    {
+        ofstream json( instJson );
+
+        if( !(json && inst->PrintJSON( json )) )
+        {
+            fprintf( stderr, "llcsim: cannot write %s\n", instJson );
+            return 1;
+        }
+    }
+
+    if( inst && instSeries && !inst->WriteSeries( instSeries ) )
+    {
+        fprintf( stderr, "llcsim: cannot write %s\n", instSeries );
+        return 1;
+    }
+
+    fprintf( stderr, "llcsim: %llu accesses in %.3f s: %.0f accesses/sec, %.2f ns/access\n", numRefs, secs, rate, ns );
+
+    delete gz;
+    delete mapped;
+    delete nextUse;
+
+    return 0;
+}